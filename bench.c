@@ -0,0 +1,159 @@
+/**
+ * Micro-benchmarks for the list functions, run by "make bench" against each build variant of the
+ * library (see the Makefile). Each line gives the average time of one operation in nanoseconds.
+ */
+
+#include "list.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define BENCH_ITEMS 100000     //items in the lists walked (must fit LIST_MAX_NUM_NODES)
+#define BENCH_ROUNDS 50        //passes over the lists per benchmark
+#define BENCH_ACCESSES 20000000 //accessor calls in the accessor benchmark
+
+// Keeps the compiler from hoisting loads out of a loop, as if the list could change between calls
+#define CLOBBER() __asm__ volatile("" ::: "memory")
+
+static double nowNs()
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec * 1e9 + now.tv_nsec;
+}
+
+static void report(const char* pVariant, const char* pName, double startNs, long operations)
+{
+    printf("%-14s %-26s %8.2f ns/op\n", pVariant, pName, (nowNs() - startNs) / operations);
+    return;
+}
+
+static bool valueEquals(void* pItem, void* pArg)
+{
+    return *(int*)pItem == *(int*)pArg;
+}
+
+static bool addToSum(void* pItem, void* pContext)
+{
+    *(long*)pContext += *(int*)pItem;
+    return true;
+}
+
+// Walks pList with List_first/List_next and List_curr, summing the items
+static long walkList(List* pList)
+{
+    long sum = 0;
+    for (int* pItem = List_first(pList); pItem != NULL; pItem = List_next(pList))
+    {
+        sum += *(int*)List_curr(pList) + List_count(pList);
+    }
+    return sum;
+}
+
+// Runs every benchmark on pList, named after the form it is in
+static long benchList(const char* pVariant, const char* pForm, List* pList, int* pMissing)
+{
+    char name[64];
+    long sum = 0;
+
+    snprintf(name, sizeof(name), "walk next/curr (%s)", pForm);
+    double start = nowNs();
+    for (int round = 0; round < BENCH_ROUNDS; round++)
+    {
+        sum += walkList(pList);
+    }
+    report(pVariant, name, start, (long) BENCH_ROUNDS * BENCH_ITEMS);
+
+    snprintf(name, sizeof(name), "foreach (%s)", pForm);
+    start = nowNs();
+    for (int round = 0; round < BENCH_ROUNDS; round++)
+    {
+        List_foreach(pList, addToSum, &sum);
+    }
+    report(pVariant, name, start, (long) BENCH_ROUNDS * BENCH_ITEMS);
+
+    snprintf(name, sizeof(name), "search miss (%s)", pForm);
+    start = nowNs();
+    for (int round = 0; round < BENCH_ROUNDS; round++)
+    {
+        List_first(pList);
+        sum += List_search(pList, valueEquals, pMissing) == NULL;
+    }
+    report(pVariant, name, start, (long) BENCH_ROUNDS * BENCH_ITEMS);
+    return sum;
+}
+
+int main(int argCount, char* args[])
+{
+    const char* pVariant = argCount > 1 ? args[1] : "default";
+    int* values = malloc(BENCH_ITEMS * sizeof(int));
+    int missing = -1;
+    long sum = 0;
+    for (int i = 0; i < BENCH_ITEMS; i++)
+    {
+        values[i] = i;
+    }
+
+    //accessors alone: the call is most of the cost unless they are inlined
+    List* pList = List_create();
+    List_append(pList, &values[0]);
+    double start = nowNs();
+    for (long i = 0; i < BENCH_ACCESSES; i++)
+    {
+        CLOBBER();
+        sum += List_count(pList) + (List_curr(pList) != NULL);
+    }
+    report(pVariant, "count + curr", start, BENCH_ACCESSES);
+    List_trim(pList);
+
+    //deque churn in ring form
+    start = nowNs();
+    for (int round = 0; round < BENCH_ROUNDS; round++)
+    {
+        for (int i = 0; i < BENCH_ITEMS; i++)
+        {
+            List_append(pList, &values[i]);
+        }
+        for (int i = 0; i < BENCH_ITEMS; i++)
+        {
+            List_first(pList);
+            sum += *(int*)List_remove(pList);
+        }
+    }
+    report(pVariant, "append + remove (ring)", start, (long) BENCH_ROUNDS * BENCH_ITEMS);
+
+    //walks, over the same items in ring form and then in nodes
+    for (int i = 0; i < BENCH_ITEMS; i++)
+    {
+        List_append(pList, &values[i]);
+    }
+    sum += benchList(pVariant, "ring", pList, &missing);
+    List_first(pList);
+    List_add(pList, &missing); //adding in the middle moves the items into nodes
+    List_remove(pList);
+    sum += benchList(pVariant, "nodes", pList, &missing);
+
+    //churn on nodes, in the middle of the list
+    start = nowNs();
+    for (int round = 0; round < BENCH_ROUNDS; round++)
+    {
+        List_first(pList);
+        for (int i = 0; i < BENCH_ITEMS / 2; i++)
+        {
+            List_add(pList, &missing);
+            List_next(pList);
+        }
+        List_first(pList);
+        for (int i = 0; i < BENCH_ITEMS / 2; i++)
+        {
+            List_next(pList);
+            sum += *(int*)List_remove(pList);
+        }
+    }
+    report(pVariant, "add + remove (nodes)", start, (long) BENCH_ROUNDS * BENCH_ITEMS);
+
+    fprintf(stderr, "%ld\n", sum); //keeps the results alive
+    free(values);
+    return 0;
+}
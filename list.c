@@ -9,75 +9,420 @@
 #include <stdbool.h>
 #include <stddef.h>
 #include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdatomic.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#define LIST_IMPLEMENTATION //the accessors are defined here, never inline
 #include "list.h"
 
 static bool firstCreate = true;
 
 static List heads[LIST_MAX_NUM_HEADS];    //create pool of list heads
-static Node nodes[LIST_MAX_NUM_NODES];    //create pool of list nodes
+static Node * nodes = NULL;               //pool of list nodes, mapped upon the first List_create()
 
 //tracking idea: 
-//two arrays containing index of the nodes/heads
-//index tracker keeps all used nodes/heads's indicies to the left of the tracker, unused to the right
-//when a node/head is freed, its index is put in the array before the tracker and tracker is decremented 
+//a bump index splits each pool into heads/nodes that have been handed out at least once (to the left)
+//and heads/nodes that never have (to the right), so nothing needs initializing up front
+//when a node/head is freed, its index is pushed onto a stack of recycled indices, 
+//which is popped before the bump index moves on
 
-static int freeHeads[LIST_MAX_NUM_HEADS];    //array of free list heads
-static int freeNodes[LIST_MAX_NUM_NODES];    //array of free list nodes
+static int freeHeads[LIST_MAX_NUM_HEADS];    //stack of recycled list heads
+static int * freeNodes = NULL;               //stack of recycled list nodes, mapped along with nodes
 
-static int freeHeadIndex = 0;       //index of first free head in freeHeads
-static int freeNodeIndex = 0;       //index of first free node in freeNodes
+static int freeHeadCount = 0;       //number of heads on the freeHeads stack
+static int freeNodeCount = 0;       //number of nodes on the freeNodes stack
+static int nextUnusedHead = 0;      //index of the first head that has never been handed out
+static int nextUnusedNode = 0;      //index of the first node that has never been handed out
+static int reservedNodes = 0;       //free nodes reserved by items of lists in ring form
+
+//epoch mode (see List_epoch_enable in list.h):
+//a node taken out of a list goes to the limbo list of the epoch it was taken out in, chained through 
+//its prev pointer so that a reader still standing on it can follow next as before. The writer moves
+//the epoch on once every reader inside a read-side section has seen the current one; a reader that
+//could still reach a node taken out in epoch e started no later than e, so once the epoch reaches
+//e + 2 that limbo list is pushed back onto the freeNodes stack
+#define EPOCH_LIMBO_COUNT 3          //limbo lists in use at once: epochs e - 2 (being reclaimed), e - 1 and e
+#define EPOCH_ADVANCE_INTERVAL 64    //nodes taken out between attempts to move the epoch on
+
+typedef struct ReaderSlot_s ReaderSlot;
+struct ReaderSlot_s
+{
+    _Alignas(64) atomic_ulong state;   //epoch the reader entered in shifted left by one, low bit set while inside
+    atomic_bool claimed;               //held by a thread (released when the thread exits)
+};
+
+static bool epochMode = false;
+static atomic_ulong globalEpoch = 0;
+static Node * limbo[EPOCH_LIMBO_COUNT];     //nodes taken out in each epoch, chained through prev
+static int retiredSinceAdvance = 0;         //nodes taken out since the last attempt to move the epoch on
+static ReaderSlot readerSlots[LIST_MAX_READERS];
+static atomic_int readerSlotCount = 0;      //slots ever claimed, so the writer only scans those
+static _Thread_local ReaderSlot * pThreadSlot = NULL;
+static pthread_key_t readerKey;
+static pthread_once_t readerKeyOnce = PTHREAD_ONCE_INIT;
+
+#define HUGE_PAGE_SIZE ((size_t) 2 << 20)
+#define RING_INITIAL_CAPACITY 8 //slots in the ring of a list upon its first item (a power of two)
 
 //HELPER FUNCTIONS:
+//maps the node pool and its free stack upon the first call of List_create()
+//pages are only committed once a node on them is first handed out
+static bool mapNodePool()
+{
+    size_t nodesSize = (size_t) LIST_MAX_NUM_NODES * sizeof(Node);
+    size_t poolSize = nodesSize + (size_t) LIST_MAX_NUM_NODES * sizeof(int);
+    void * pool = MAP_FAILED;
+
+#if LIST_HUGE_PAGES == 2 && defined(MAP_HUGETLB)
+    //no MAP_NORESERVE here: the huge pages must be reserved up front, or touching one that 
+    //turns out to be missing raises SIGBUS instead of failing the mmap
+    size_t hugePoolSize = (poolSize + HUGE_PAGE_SIZE - 1) & ~(HUGE_PAGE_SIZE - 1);
+    pool = mmap(NULL, hugePoolSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+#endif
+    if (pool == MAP_FAILED) //no huge pages reserved (or not asked for), use regular pages
+    {
+#if LIST_HUGE_PAGES >= 1 && defined(MADV_HUGEPAGE)
+        //transparent huge pages only back 2MB aligned ranges, so the pool is rounded up to whole huge 
+        //pages and placed on a 2MB boundary: a huge page more is reserved, and the slack is unmapped
+        if (poolSize >= HUGE_PAGE_SIZE)
+        {
+            size_t alignedPoolSize = (poolSize + HUGE_PAGE_SIZE - 1) & ~(HUGE_PAGE_SIZE - 1);
+            char * reserved = mmap(NULL, alignedPoolSize + HUGE_PAGE_SIZE, PROT_READ | PROT_WRITE, 
+                                   MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+            if (reserved == MAP_FAILED)
+            {
+                return false;
+            }
+            char * aligned = (char *) (((uintptr_t) reserved + HUGE_PAGE_SIZE - 1) & ~(uintptr_t) (HUGE_PAGE_SIZE - 1));
+            if (aligned > reserved)
+            {
+                munmap(reserved, aligned - reserved);
+            }
+            munmap(aligned + alignedPoolSize, reserved + HUGE_PAGE_SIZE - aligned);
+            madvise(aligned, alignedPoolSize, MADV_HUGEPAGE); //let the kernel back it with transparent huge pages
+            pool = aligned;
+        }
+#endif
+    }
+    if (pool == MAP_FAILED) //a small pool (or no huge pages asked for)
+    {
+        pool = mmap(NULL, poolSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+        if (pool == MAP_FAILED)
+        {
+            return false;
+        }
+    }
+
+    nodes = pool;
+    freeNodes = (int *) ((char *) pool + nodesSize);
+    return true;
+}
+
+//stores a link that readers in a read-side section may follow, after the node it points to is set up
+static void publishLink(Node ** pLink, Node * pNode)
+{
+    __atomic_store_n(pLink, pNode, __ATOMIC_RELEASE);
+    return;
+}
+
 //initializes the first node of the list
 static void initializeFirstNode(List * pList, Node * newNode) //initializes the first ever node in a list
 {
-    pList -> head = newNode;
+    newNode -> prev = NULL;
+    newNode -> next = NULL;
+    publishLink(&pList -> head, newNode);
     pList -> tail = newNode;
-    pList -> head -> prev = NULL;
-    pList -> tail -> next = NULL;
     pList -> current = newNode;
     pList -> currentPosition = 1;
     pList -> itemCount = 1;
     return;
 }
 
+//pushes the nodes in a limbo list back onto the freeNodes stack
+static void reclaimLimbo(int limboIndex)
+{
+    for (Node * pNode = limbo[limboIndex]; pNode != NULL; pNode = pNode -> prev)
+    {
+        freeNodes[freeNodeCount] = pNode -> nodeIndex;
+        freeNodeCount++;
+    }
+    limbo[limboIndex] = NULL;
+    return;
+}
+
+//moves the epoch on if every reader inside a read-side section has seen the current one, 
+//and reclaims the limbo list that no reader can reach anymore
+//returns false if a reader is still in an older epoch
+static bool tryAdvanceEpoch()
+{
+    unsigned long epoch = atomic_load_explicit(&globalEpoch, memory_order_relaxed);
+    atomic_thread_fence(memory_order_seq_cst); //pairs with the fence in List_reader_enter()
+    int slotCount = atomic_load_explicit(&readerSlotCount, memory_order_acquire);
+    for (int i = 0; i < slotCount; i++)
+    {
+        unsigned long state = atomic_load_explicit(&readerSlots[i].state, memory_order_acquire);
+        if ((state & 1) && (state >> 1) != epoch)
+        {
+            return false;
+        }
+    }
+    atomic_store_explicit(&globalEpoch, epoch + 1, memory_order_release);
+    reclaimLimbo((epoch + 2) % EPOCH_LIMBO_COUNT); //taken out in epoch - 1, two epochs before the new one
+    return true;
+}
+
+//checks if every node is in use or reserved by an item in ring form
+//in epoch mode, the epoch is moved on first to get back nodes that no reader can reach anymore
+static bool noFreeNodes()
+{
+    for (int i = 0; epochMode && i < EPOCH_LIMBO_COUNT; i++)
+    {
+        if (freeNodeCount + (LIST_MAX_NUM_NODES - nextUnusedNode) > reservedNodes || !tryAdvanceEpoch())
+        {
+            break;
+        }
+    }
+    return freeNodeCount + (LIST_MAX_NUM_NODES - nextUnusedNode) <= reservedNodes;
+}
+
 //create a new node from the available nodes
 static Node * createNewNode(void * pItem)
 {
-    if (freeNodeIndex >= LIST_MAX_NUM_NODES) //if all nodes are used
+    Node * newNode;
+    if (freeNodeCount > 0) //reuse a freed node first
+    {
+        freeNodeCount--;
+        newNode = &nodes[freeNodes[freeNodeCount]];
+    }
+    else if (nextUnusedNode < LIST_MAX_NUM_NODES) //otherwise take a node that has never been used
+    {
+        newNode = &nodes[nextUnusedNode];
+        newNode -> nodeIndex = nextUnusedNode;
+        nextUnusedNode++;
+    }
+    else //if all nodes are used
     {
         return NULL;
     }
-
-    Node * newNode = &nodes[freeNodes[freeNodeIndex]]; //take free node from the free nodes list
-    freeNodeIndex++;
     newNode -> item = pItem;
     return newNode;
 }
 
+//puts the node back into pool of free nodes
+//in epoch mode, the node goes to limbo instead, keeping its item and next pointer for readers still on it
+static void releaseNode(Node * pNode)
+{
+    if (epochMode)
+    {
+        int limboIndex = atomic_load_explicit(&globalEpoch, memory_order_relaxed) % EPOCH_LIMBO_COUNT;
+        pNode -> prev = limbo[limboIndex];
+        limbo[limboIndex] = pNode;
+        retiredSinceAdvance++;
+        if (retiredSinceAdvance >= EPOCH_ADVANCE_INTERVAL)
+        {
+            retiredSinceAdvance = 0;
+            tryAdvanceEpoch();
+        }
+        return;
+    }
+    freeNodes[freeNodeCount] = pNode -> nodeIndex;
+    freeNodeCount++;
+    return;
+}
+
+//puts the head back into pool of heads
+static void releaseHead(List * pList)
+{
+    freeHeads[freeHeadCount] = pList -> headIndex;
+    freeHeadCount++;
+    return;
+}
+
+//RING FORM (see List_s in list.h):
+//every item kept in a ring reserves one node from the pool, so a list holds as many items 
+//either way and switching to nodes can never run out of them
 
-//initializes the free trackers upon first call of create_List()
-static void initializeFreeArrays()
+//returns the slot holding the item at position index (0 for the first item)
+static void ** ringSlot(List * pList, int index)
 {
-    for (int i = 0; i < LIST_MAX_NUM_HEADS; i++) 
+    return &pList -> ring[(pList -> ringStart + index) & (pList -> ringCapacity - 1)];
+}
+
+//returns the current item of a list in ring form
+static void * ringCurrentItem(List * pList)
+{
+    if (pList -> currentIndex < 0 || pList -> currentIndex >= pList -> itemCount)
+    {
+        return NULL;
+    }
+    return *ringSlot(pList, pList -> currentIndex);
+}
+
+//sets currentPosition to match currentIndex, so that it reads the same as for a list of nodes
+static void syncRingPosition(List * pList)
+{
+    if (pList -> itemCount == 0)
+    {
+        pList -> currentIndex = -1;
+        pList -> currentPosition = -1;
+    }
+    else if (pList -> currentIndex < 0)
+    {
+        pList -> currentIndex = -1;
+        pList -> currentPosition = 0;
+    }
+    else if (pList -> currentIndex >= pList -> itemCount)
+    {
+        pList -> currentIndex = pList -> itemCount;
+        pList -> currentPosition = 4;
+    }
+    else if (pList -> currentIndex == 0)
+    {
+        pList -> currentPosition = 1;
+    }
+    else if (pList -> currentIndex == pList -> itemCount - 1)
+    {
+        pList -> currentPosition = 3;
+    }
+    else
+    {
+        pList -> currentPosition = 2;
+    }
+    return;
+}
+
+//makes room for one more item, doubling the ring when it is full
+static bool growRing(List * pList)
+{
+    if (pList -> itemCount < pList -> ringCapacity)
+    {
+        return true;
+    }
+
+    int newCapacity = pList -> ringCapacity == 0 ? RING_INITIAL_CAPACITY : pList -> ringCapacity * 2;
+    void ** newRing = malloc(newCapacity * sizeof(void *));
+    if (newRing == NULL)
     {
-        freeHeads[i] = i;
-        heads[i].headIndex = i;
+        return false;
     }
-    for (int i = 0; i < LIST_MAX_NUM_NODES; i++) 
+    for (int i = 0; i < pList -> itemCount; i++) //unwrap the items to the start of the new ring
     {
-        freeNodes[i] = i;
-        nodes[i].nodeIndex = i;
+        newRing[i] = *ringSlot(pList, i);
+    }
+    free(pList -> ring);
+    pList -> ring = newRing;
+    pList -> ringCapacity = newCapacity;
+    pList -> ringStart = 0;
+    return true;
+}
+
+//adds an item to the end of a list in ring form and makes it the current one
+//returns false if the ring could not grow
+static bool ringPushBack(List * pList, void * pItem)
+{
+    if (!growRing(pList))
+    {
+        return false;
+    }
+    *ringSlot(pList, pList -> itemCount) = pItem;
+    pList -> itemCount++;
+    reservedNodes++;
+    pList -> currentIndex = pList -> itemCount - 1;
+    syncRingPosition(pList);
+    return true;
+}
+
+//adds an item to the front of a list in ring form and makes it the current one
+//returns false if the ring could not grow
+static bool ringPushFront(List * pList, void * pItem)
+{
+    if (!growRing(pList))
+    {
+        return false;
+    }
+    pList -> ringStart = (pList -> ringStart - 1) & (pList -> ringCapacity - 1);
+    *ringSlot(pList, 0) = pItem;
+    pList -> itemCount++;
+    reservedNodes++;
+    pList -> currentIndex = 0;
+    syncRingPosition(pList);
+    return true;
+}
+
+//takes the first item out of a list in ring form, leaving the current item to the caller
+static void * ringPopFront(List * pList)
+{
+    void * pItem = *ringSlot(pList, 0);
+    pList -> ringStart = (pList -> ringStart + 1) & (pList -> ringCapacity - 1);
+    pList -> itemCount--;
+    reservedNodes--;
+    return pItem;
+}
+
+//takes the last item out of a list in ring form, leaving the current item to the caller
+static void * ringPopBack(List * pList)
+{
+    pList -> itemCount--;
+    reservedNodes--;
+    return *ringSlot(pList, pList -> itemCount);
+}
+
+//releases the ring of a list in ring form along with the nodes its items reserve
+static void freeRing(List * pList)
+{
+    reservedNodes -= pList -> itemCount;
+    free(pList -> ring);
+    pList -> ring = NULL;
+    pList -> ringCapacity = 0;
+    pList -> ringStart = 0;
+    return;
+}
+
+//moves the items of a list in ring form into nodes, keeping the same current item
+static void convertToNodes(List * pList)
+{
+    int count = pList -> itemCount;
+    pList -> head = NULL;
+    pList -> tail = NULL;
+    pList -> current = NULL;
+    for (int i = 0; i < count; i++)
+    {
+        Node * pNode = createNewNode(*ringSlot(pList, i));
+        pNode -> prev = pList -> tail;
+        pNode -> next = NULL;
+        if (pList -> tail == NULL)
+        {
+            pList -> head = pNode;
+        }
+        else
+        {
+            pList -> tail -> next = pNode;
+        }
+        pList -> tail = pNode;
+        if (i == pList -> currentIndex)
+        {
+            pList -> current = pNode;
+        }
     }
+
+    freeRing(pList); //the items now hold the nodes they had reserved
+    pList -> isLinked = true; //currentPosition already reads the same for nodes
     return;
 }
 
 //adds node to the end of the list
 static void addNodeToTail(List * pList, Node * pNode)
 {
-    pList -> tail -> next = pNode;
     pNode -> prev = pList -> tail;
     pNode -> next = NULL;
+    publishLink(&pList -> tail -> next, pNode);
     pList -> tail = pNode;
     pList -> current = pNode;
     pList -> currentPosition = 3;
@@ -88,10 +433,10 @@ static void addNodeToTail(List * pList, Node * pNode)
 //adds node to the start of the list
 static void addNodeToHead(List * pList, Node * pNode)
 {   
-    pList -> head -> prev = pNode;
     pNode -> next = pList -> head;
     pNode -> prev = NULL;
-    pList -> head = pNode;
+    pList -> head -> prev = pNode;
+    publishLink(&pList -> head, pNode);
     pList -> current = pNode;
     pList -> currentPosition = 1;
     pList -> itemCount++;
@@ -102,18 +447,30 @@ static void addNodeToHead(List * pList, Node * pNode)
 // Returns a NULL pointer on failure.
 List* List_create()
 {
-    if (firstCreate){       //the very first time we call List_create(), we want to initialize the two pools 
-        initializeFreeArrays();
+    if (firstCreate){       //the very first time we call List_create(), we want to map the node pool 
+        if (!mapNodePool())
+        {
+            return NULL;
+        }
         firstCreate = false;
     }
 
-    if (freeHeadIndex >= LIST_MAX_NUM_HEADS) //if all list heads have been used, return null
+    List * newList;
+    if (freeHeadCount > 0) //take a freed head first
+    {
+        freeHeadCount--;
+        newList = &heads[freeHeads[freeHeadCount]];
+    }
+    else if (nextUnusedHead < LIST_MAX_NUM_HEADS) //otherwise take a head that has never been used
+    {
+        newList = &heads[nextUnusedHead];
+        newList -> headIndex = nextUnusedHead;
+        nextUnusedHead++;
+    }
+    else //if all list heads have been used, return null
     {
         return NULL;
     }
-    
-    List * newList = &heads[freeHeads[freeHeadIndex]]; //take a free head from the free heads array and increment past its index
-    freeHeadIndex++;
 
     newList -> head = NULL;  //set default initial conditions (safety)
     newList -> tail = NULL;
@@ -121,6 +478,12 @@ List* List_create()
     newList -> currentPosition = -1;
     newList -> itemCount = 0;
 
+    newList -> isLinked = epochMode; //every list starts out in ring form, unless readers may walk it
+    newList -> ring = NULL;
+    newList -> ringCapacity = 0;
+    newList -> ringStart = 0;
+    newList -> currentIndex = -1;
+
     return newList;
 }
 
@@ -138,6 +501,12 @@ void* List_first(List* pList)
     {
         return NULL;
     }
+    if (!pList -> isLinked)
+    {
+        pList -> currentIndex = 0;
+        syncRingPosition(pList);
+        return *ringSlot(pList, 0);
+    }
     pList -> current = pList -> head; //set current position to head
     pList -> currentPosition = 1;
     return pList -> head -> item;
@@ -150,6 +519,12 @@ void* List_last(List* pList)
     {
         return NULL;
     }
+    if (!pList -> isLinked)
+    {
+        pList -> currentIndex = pList -> itemCount - 1;
+        syncRingPosition(pList);
+        return *ringSlot(pList, pList -> currentIndex);
+    }
     pList -> current = pList -> tail; //set current position to tail
     pList -> currentPosition = 3;
     return pList -> tail -> item;
@@ -160,7 +535,17 @@ void* List_last(List* pList)
 // is returned and the current item is set to be beyond end of pList.
 void* List_next(List* pList)
 {
-    if (pList -> itemCount == 1)
+    if (!pList -> isLinked)
+    {
+        if (pList -> itemCount > 0) //syncRingPosition() stops it past the list
+        {
+            pList -> currentIndex++;
+            syncRingPosition(pList);
+        }
+        return ringCurrentItem(pList);
+    }
+
+    if (pList -> itemCount == 1 && pList -> currentPosition == 1)
     {
         pList -> currentPosition = 3;
     }
@@ -203,6 +588,16 @@ void* List_next(List* pList)
 // is returned and the current item is set to be before the start of pList.
 void* List_prev(List* pList)
 {
+    if (!pList -> isLinked)
+    {
+        if (pList -> itemCount > 0) //syncRingPosition() stops it before the list
+        {
+            pList -> currentIndex--;
+            syncRingPosition(pList);
+        }
+        return ringCurrentItem(pList);
+    }
+
     switch(pList -> currentPosition)
     {
         case 1:     
@@ -223,8 +618,15 @@ void* List_prev(List* pList)
                 pList -> current = NULL;
                 return NULL;
             }
-            pList -> currentPosition = 2;
             pList -> current = pList -> current -> prev;
+            if (pList -> current == pList -> head)
+            {
+                pList -> currentPosition = 1;
+            }
+            else
+            {
+                pList -> currentPosition = 2;
+            }
             return pList -> current -> item;
         case 4:                     //when current is beyond the list, set current to tail
             pList -> current = pList -> tail;  
@@ -238,6 +640,10 @@ void* List_prev(List* pList)
 // Returns a pointer to the current item in pList.
 void* List_curr(List* pList)
 {
+    if (!pList -> isLinked)
+    {
+        return ringCurrentItem(pList);
+    }
     if (pList -> current == NULL)
     {
         return NULL;
@@ -251,14 +657,33 @@ void* List_curr(List* pList)
 // Returns 0 on success, -1 on failure.
 int List_add(List* pList, void* pItem)
 {   
-    if (freeNodeIndex >= LIST_MAX_NUM_NODES)
+    if (noFreeNodes())
     {
         return -1;
     }    
 
+    if (!pList -> isLinked)
+    {
+        if (pList -> currentIndex >= pList -> itemCount - 1) //on the tail, past the list, or empty
+        {
+            if (ringPushBack(pList, pItem))
+            {
+                return 0;
+            }
+        }
+        else if (pList -> currentIndex < 0) //before the list
+        {
+            if (ringPushFront(pList, pItem))
+            {
+                return 0;
+            }
+        }
+        convertToNodes(pList); //adding in the middle (or the ring could not grow) needs nodes
+    }
+
     Node * newNode = createNewNode(pItem);
 
-    if (pList -> itemCount == 1) //when there is only one node, we want it to prepend to tail, not head
+    if (pList -> itemCount == 1 && pList -> currentPosition == 1) //when there is only one node, we want it to prepend to tail, not head
     {
         pList -> currentPosition = 3;       
     }
@@ -274,10 +699,11 @@ int List_add(List* pList, void* pItem)
         case 1: //when current is in the list/head
         case 2:
             newNode -> next = pList -> current -> next;
-            pList -> current -> next = newNode; 
-            newNode -> next -> prev = newNode;
             newNode -> prev = pList -> current;
+            newNode -> next -> prev = newNode;
+            publishLink(&pList -> current -> next, newNode);
             pList -> current = newNode;    
+            pList -> currentPosition = 2;
             pList -> itemCount++;    
             break;    
         case 3: //when current is after the list or on tail
@@ -294,14 +720,33 @@ int List_add(List* pList, void* pItem)
 // Returns 0 on success, -1 on failure.
 int List_insert(List* pList, void* pItem)
 {
-    if (freeNodeIndex >= LIST_MAX_NUM_NODES)
+    if (noFreeNodes())
     {
         return -1;
     }    
 
+    if (!pList -> isLinked)
+    {
+        if (pList -> currentIndex <= 0) //on the head, before the list, or empty
+        {
+            if (ringPushFront(pList, pItem))
+            {
+                return 0;
+            }
+        }
+        else if (pList -> currentIndex >= pList -> itemCount) //past the list
+        {
+            if (ringPushBack(pList, pItem))
+            {
+                return 0;
+            }
+        }
+        convertToNodes(pList); //inserting in the middle (or the ring could not grow) needs nodes
+    }
+
     Node * newNode = createNewNode(pItem);
 
-    if (pList -> itemCount == 1) //when there is only one node, we want to prepend to head
+    if (pList -> itemCount == 1 && pList -> currentPosition == 3) //when there is only one node, we want to prepend to head
     {
         pList -> currentPosition = 1;       
     }    
@@ -318,9 +763,11 @@ int List_insert(List* pList, void* pItem)
         case 2: 
         case 3:  //if not on head or node, insert         
             newNode -> prev = pList -> current -> prev;
-            pList -> current -> prev = newNode;
             newNode -> next = pList -> current;
-            newNode -> prev -> next = newNode;
+            pList -> current -> prev = newNode;
+            publishLink(&newNode -> prev -> next, newNode);
+            pList -> current = newNode;
+            pList -> currentPosition = 2;
             pList -> itemCount++;
             break;
         case 4:
@@ -334,11 +781,20 @@ int List_insert(List* pList, void* pItem)
 // Returns 0 on success, -1 on failure.
 int List_append(List* pList, void* pItem)
 {
-    if (freeNodeIndex >= LIST_MAX_NUM_NODES) //when no free nodes, return 
+    if (noFreeNodes()) //when no free nodes, return 
     {
         return -1;
     }    
 
+    if (!pList -> isLinked)
+    {
+        if (ringPushBack(pList, pItem))
+        {
+            return 0;
+        }
+        convertToNodes(pList); //the ring could not grow, carry on with nodes
+    }
+
     Node * newNode = createNewNode(pItem);
 
     switch (pList -> currentPosition)
@@ -357,11 +813,20 @@ int List_append(List* pList, void* pItem)
 // Returns 0 on success, -1 on failure.
 int List_prepend(List* pList, void* pItem)
 {
-    if (freeNodeIndex >= LIST_MAX_NUM_NODES) //when no free nodes
+    if (noFreeNodes()) //when no free nodes
     {
         return -1;
     }    
 
+    if (!pList -> isLinked)
+    {
+        if (ringPushFront(pList, pItem))
+        {
+            return 0;
+        }
+        convertToNodes(pList); //the ring could not grow, carry on with nodes
+    }
+
     Node * newNode = createNewNode(pItem);
 
     switch (pList -> currentPosition)
@@ -380,18 +845,49 @@ int List_prepend(List* pList, void* pItem)
 // then do not change the pList and return NULL.
 void* List_remove(List* pList)
 {
+    if (!pList -> isLinked)
+    {
+        if (pList -> currentIndex < 0 || pList -> currentIndex >= pList -> itemCount) //when current is not in the list
+        {
+            return NULL;
+        }
+        void * pItem = ringCurrentItem(pList);
+        if (pList -> currentIndex == 0) //the next item moves up to the head
+        {
+            ringPopFront(pList);
+            syncRingPosition(pList);
+            return pItem;
+        }
+        if (pList -> currentIndex == pList -> itemCount - 1) //current ends up past the list
+        {
+            ringPopBack(pList);
+            pList -> currentIndex = pList -> itemCount;
+            syncRingPosition(pList);
+            return pItem;
+        }
+        convertToNodes(pList); //removing from the middle needs nodes
+    }
+
     Node * tempNode = pList -> current;
 
+    if (tempNode == NULL) //when current is not in the list, return null
+    {
+        return NULL;
+    }
+
     if (pList -> itemCount == 1) //if there is only one node, we can simply remove it
     {
         pList -> currentPosition = -1;
+        pList -> current = NULL;
+        publishLink(&pList -> head, NULL);
+        pList -> tail = NULL;
     }
     else
     {
         switch (pList -> currentPosition)
         {
             case 1:
-                pList -> head = pList -> head -> next;
+                publishLink(&pList -> head, pList -> head -> next);
                 pList -> head -> prev = NULL;
                 pList -> current = pList -> head;
                 pList -> currentPosition = 1;
@@ -399,7 +895,7 @@ void* List_remove(List* pList)
             case 2:
                 pList -> current = pList -> current -> next;
                 pList -> current -> prev = tempNode -> prev;
-                tempNode -> prev -> next = pList -> current;
+                publishLink(&tempNode -> prev -> next, pList -> current);
 
                 if (pList -> current == pList -> tail)
                 {
@@ -408,7 +904,7 @@ void* List_remove(List* pList)
                 break;
             case 3:
                 pList -> tail = pList -> tail -> prev;
-                pList -> tail -> next = NULL;
+                publishLink(&pList -> tail -> next, NULL);
                 pList -> currentPosition = 4;
                 pList -> current = NULL;
                 break;
@@ -417,8 +913,7 @@ void* List_remove(List* pList)
         }
     }
     pList -> itemCount--;
-    freeNodeIndex--; //put the node back into pool of free nodes
-    freeNodes[freeNodeIndex] = tempNode -> nodeIndex;
+    releaseNode(tempNode);
     return tempNode -> item;
 }
 
@@ -427,24 +922,63 @@ void* List_remove(List* pList)
 // for future operations.
 void List_concat(List* pList1, List* pList2)
 {
-    if (pList1 -> itemCount == 0) //if first list is empty, just copy second list
+    if (!pList1 -> isLinked && !pList2 -> isLinked) //both in ring form: move the items over
+    {
+        int i = 0;
+        while (i < pList2 -> itemCount && growRing(pList1))
+        {
+            *ringSlot(pList1, pList1 -> itemCount) = *ringSlot(pList2, i);
+            pList1 -> itemCount++;
+            i++;
+        }
+        if (i == pList2 -> itemCount)
+        {
+            pList1 -> currentIndex = pList1 -> currentPosition == 4 ? pList1 -> itemCount : pList1 -> currentIndex;
+            syncRingPosition(pList1);
+            pList2 -> itemCount = 0; //the moved items keep their reserved nodes
+            freeRing(pList2);
+            releaseHead(pList2);
+            return;
+        }
+        pList1 -> itemCount -= i; //pList1 could not grow: undo and join them as nodes instead
+    }
+    if (!pList1 -> isLinked)
+    {
+        convertToNodes(pList1);
+    }
+    if (!pList2 -> isLinked)
+    {
+        convertToNodes(pList2);
+    }
+
+    if (pList1 -> itemCount == 0) //if first list is empty, take over the second list
     {
-        pList1 = pList2;
+        if (pList2 -> itemCount != 0)
+        {
+            publishLink(&pList1 -> head, pList2 -> head);
+            pList1 -> tail = pList2 -> tail;
+            pList1 -> itemCount = pList2 -> itemCount;
+            pList1 -> current = NULL;
+            pList1 -> currentPosition = 0;
+        }
     }
     else
     {
         if (pList2 -> itemCount != 0) //if second list is empty, do nothing
         {
-            pList1 -> tail -> next = pList2 -> head;
             pList2 -> head -> prev = pList1 -> tail;
+            publishLink(&pList1 -> tail -> next, pList2 -> head);
 
             pList1 -> tail = pList2 -> tail;
             pList1 -> itemCount += pList2 -> itemCount; 
+            if (pList1 -> currentPosition == 3) //the old tail is now in the middle
+            {
+                pList1 -> currentPosition = 2;
+            }
         }  
     }
 
-    freeHeadIndex--;
-    freeHeads[freeHeadIndex] = pList2 -> headIndex;
+    releaseHead(pList2);
     return;
 }
 
@@ -455,25 +989,32 @@ void List_concat(List* pList1, List* pList2)
 typedef void (*FREE_FN)(void* pItem);
 void List_free(List* pList, FREE_FN pItemFreeFn)
 {
-    pList -> current = pList -> head;
+    if (!pList -> isLinked)
+    {
+        for (int i = 0; i < pList -> itemCount; i++)
+        {
+            (*pItemFreeFn)(*ringSlot(pList, i));
+        }
+        freeRing(pList);
+    }
+
+    pList -> current = pList -> isLinked ? pList -> head : NULL;
+    publishLink(&pList -> head, NULL); //unlink every node before any of them goes back into the pool
 
     while (pList -> current != NULL) //go through each node and free it
     {
-        freeNodeIndex--;
-        freeNodes[freeNodeIndex] = pList -> current -> nodeIndex;
+        releaseNode(pList -> current);
         (*pItemFreeFn)(pList -> current -> item);
 
         pList -> current = pList -> current -> next;
     }
 
     pList -> current = NULL; //reset initial conditions before returning list
-    pList -> head = NULL;
     pList -> tail = NULL;
     pList -> currentPosition = -1;
     pList -> itemCount = 0;
 
-    freeHeadIndex--; //put released head back into pool of heads
-    freeHeads[freeHeadIndex] = pList -> headIndex;
+    releaseHead(pList); //put released head back into pool of heads
     return;
 }
 
@@ -486,24 +1027,34 @@ void* List_trim(List* pList)
         return NULL;
     }
 
-    freeNodeIndex--;
-    freeNodes[freeNodeIndex] = pList -> tail -> nodeIndex; //put the tail back into pool of free nodes
+    if (!pList -> isLinked)
+    {
+        void * pItem = ringPopBack(pList);
+        pList -> currentIndex = pList -> itemCount - 1;
+        syncRingPosition(pList);
+        return pItem;
+    }
+
+    Node * tempNode = pList -> tail;
 
     if (pList -> itemCount == 1) //if there is only one node, set position to -1 and current to null
     {
         pList -> currentPosition = -1;
         pList -> current = NULL;
+        publishLink(&pList -> head, NULL);
+        pList -> tail = NULL;
     }
     else
     {
         pList -> tail = pList -> tail -> prev;
         pList -> current = pList -> tail;
         pList -> currentPosition = 3;
-        pList -> tail -> next = NULL;
+        publishLink(&pList -> tail -> next, NULL);
     }
     
+    releaseNode(tempNode); //put the old tail back into pool of free nodes (its prev may be reused in epoch mode)
     pList -> itemCount--; 
-    return nodes[freeNodes[freeNodeIndex]].item;
+    return tempNode -> item;
 }
 
 // Search pList, starting at the current item, until the end is reached or a match is found. 
@@ -520,24 +1071,45 @@ void* List_trim(List* pList)
 typedef bool (*COMPARATOR_FN)(void* pItem, void* pComparisonArg);
 void* List_search(List* pList, COMPARATOR_FN pComparator, void* pComparisonArg)
 {
-    switch (pList -> currentPosition)
+    if (!pList -> isLinked)
     {
-        case 0:
-            pList -> current = pList -> head; //if before list, then start at head
-        case 1:
-        case 2: 
-        case 3:
-            while (pList -> current != NULL)
+        if (pList -> currentPosition == -1 || pList -> currentPosition == 4)
+        {
+            return NULL;
+        }
+        for (int i = pList -> currentIndex < 0 ? 0 : pList -> currentIndex; i < pList -> itemCount; i++)
+        {
+            void * pItem = *ringSlot(pList, i);
+            if ((*pComparator)(pItem, pComparisonArg))
+            {
+                pList -> currentIndex = i;
+                syncRingPosition(pList);
+                return pItem;
+            }
+        }
+        pList -> currentIndex = pList -> itemCount; //no match, leave current beyond the list
+        syncRingPosition(pList);
+        return NULL;
+    }
+
+    switch (pList -> currentPosition)
+    {
+        case 0:
+            pList -> current = pList -> head; //if before list, then start at head
+        case 1:
+        case 2: 
+        case 3:
+            while (pList -> current != NULL)
             {   
                 if ((*pComparator)(pList -> current -> item, pComparisonArg))
                 {
-                    if (pList -> current == pList -> tail) //SET NEW CURRENT POSITION
+                    if (pList -> current == pList -> head) //SET NEW CURRENT POSITION
                     {
-                        pList -> currentPosition = 3;
+                        pList -> currentPosition = 1;
                     }
-                    if (pList -> current == pList -> head)
+                    else if (pList -> current == pList -> tail)
                     {
-                        pList -> currentPosition = 1;
+                        pList -> currentPosition = 3;
                     }
                     else
                     {
@@ -556,3 +1128,917 @@ void* List_search(List* pList, COMPARATOR_FN pComparator, void* pComparisonArg)
     pList -> currentPosition = 4;
     return NULL;
 }
+
+//used by List_search_many() to find pending keys by address when there is no comparator
+typedef struct KeySlot_s KeySlot;
+struct KeySlot_s
+{
+    void * pKey;
+    int argIndex;   //first argument with this key, KEY_SLOT_EMPTY or KEY_SLOT_RESOLVED
+};
+
+#define KEY_SLOT_EMPTY -1
+#define KEY_SLOT_RESOLVED -2 //stays in the table, so that probing for other keys still runs past it
+
+//returns the slot holding pKey, or the empty slot where it would go
+static KeySlot * findKeySlot(KeySlot * pTable, int tableMask, void * pKey)
+{
+    uint64_t hash = (uint64_t) (uintptr_t) pKey * 0x9e3779b97f4a7c15ULL;
+    int i = (int) (hash >> 32) & tableMask;
+    while (pTable[i].argIndex != KEY_SLOT_EMPTY && pTable[i].pKey != pKey)
+    {
+        i = (i + 1) & tableMask;
+    }
+    return &pTable[i];
+}
+
+// Looks up argCount keys in one pass over pList, starting at the current item as List_search does.
+// Returns the number of keys that matched, or -1 if memory for the pending keys ran out.
+int List_search_many(List* pList, COMPARATOR_FN pComparator, void* pComparisonArgs[], int argCount, void* pResults[])
+{
+    for (int i = 0; i < argCount; i++)
+    {
+        pResults[i] = NULL;
+    }
+
+    //where List_search would start from
+    int index = 0;
+    Node * pNode = NULL;
+    switch (pList -> currentPosition)
+    {
+        case -1:
+        case 4:
+            return 0;
+        case 0:
+            pNode = pList -> head;
+            break;
+        default:
+            index = pList -> currentIndex;
+            pNode = pList -> current;
+    }
+
+    //with a comparator, each item is tried against the keys still pending (swapped out once matched);
+    //without one, the pending keys sit in a hash table and each item takes a single lookup
+    KeySlot * pTable = NULL;
+    int tableMask = 0;
+    int * pPending = NULL;          //pending argument indices (with a comparator)
+    int * pDuplicates = NULL;       //next argument with the same key, -1 for none (without one)
+    if (pComparator != NULL)
+    {
+        pPending = malloc((argCount > 0 ? argCount : 1) * sizeof(int));
+        if (pPending == NULL)
+        {
+            return -1;
+        }
+        for (int i = 0; i < argCount; i++)
+        {
+            pPending[i] = i;
+        }
+    }
+    else
+    {
+        int tableSize = 8;
+        while (tableSize < 2 * argCount) //at most half full, so probes stay short
+        {
+            tableSize *= 2;
+        }
+        tableMask = tableSize - 1;
+        pTable = malloc(tableSize * sizeof(KeySlot));
+        pDuplicates = malloc((argCount > 0 ? argCount : 1) * sizeof(int));
+        if (pTable == NULL || pDuplicates == NULL)
+        {
+            free(pTable);
+            free(pDuplicates);
+            return -1;
+        }
+        for (int i = 0; i < tableSize; i++)
+        {
+            pTable[i].argIndex = KEY_SLOT_EMPTY;
+        }
+        for (int i = argCount - 1; i >= 0; i--) //backwards, so each chain of duplicates is in order
+        {
+            KeySlot * pSlot = findKeySlot(pTable, tableMask, pComparisonArgs[i]);
+            pDuplicates[i] = pSlot -> argIndex; //KEY_SLOT_EMPTY ends the chain
+            pSlot -> pKey = pComparisonArgs[i];
+            pSlot -> argIndex = i;
+        }
+    }
+
+    int pendingCount = argCount;
+    int matchCount = 0;
+    while (pendingCount > 0 && (pList -> isLinked ? pNode != NULL : index < pList -> itemCount))
+    {
+        void * pItem = pList -> isLinked ? pNode -> item : *ringSlot(pList, index);
+        if (pComparator != NULL)
+        {
+            for (int j = 0; j < pendingCount; j++)
+            {
+                if ((*pComparator)(pItem, pComparisonArgs[pPending[j]]))
+                {
+                    pResults[pPending[j]] = pItem;
+                    matchCount++;
+                    pendingCount--;
+                    pPending[j] = pPending[pendingCount];
+                    j--; //try the key swapped in
+                }
+            }
+        }
+        else
+        {
+            KeySlot * pSlot = findKeySlot(pTable, tableMask, pItem);
+            if (pSlot -> argIndex >= 0) //a pending key: it and its duplicates are resolved
+            {
+                for (int i = pSlot -> argIndex; i >= 0; i = pDuplicates[i])
+                {
+                    pResults[i] = pItem;
+                    matchCount++;
+                    pendingCount--;
+                }
+                pSlot -> argIndex = KEY_SLOT_RESOLVED;
+            }
+        }
+
+        if (pList -> isLinked)
+        {
+            pNode = pNode -> next;
+        }
+        index++;
+    }
+
+    free(pPending);
+    free(pTable);
+    free(pDuplicates);
+    return matchCount;
+}
+
+// Calls pVisitFn on each item from the first to the last, and stops early as soon as it returns false.
+// Returns the item it stopped on, or NULL if every item was visited. The current pointer is not changed.
+void* List_foreach(List* pList, VISIT_FN pVisitFn, void* pContext)
+{
+    if (!pList -> isLinked)
+    {
+        for (int i = 0; i < pList -> itemCount; i++)
+        {
+            void * pItem = *ringSlot(pList, i);
+            if (!(*pVisitFn)(pItem, pContext))
+            {
+                return pItem;
+            }
+        }
+        return NULL;
+    }
+
+    //acquire loads, so that readers in a read-side section see every node fully set up
+    Node * pNode = __atomic_load_n(&pList -> head, __ATOMIC_ACQUIRE);
+    while (pNode != NULL)
+    {
+        if (!(*pVisitFn)(pNode -> item, pContext))
+        {
+            return pNode -> item;
+        }
+        pNode = __atomic_load_n(&pNode -> next, __ATOMIC_ACQUIRE);
+    }
+    return NULL;
+}
+
+// Takes every item for which pPredicate returns false out of pList in a single pass, and frees it
+// with pItemFreeFn (unless pItemFreeFn is NULL). Returns the number of items taken out.
+int List_filter_inplace(List* pList, COMPARATOR_FN pPredicate, void* pContext, FREE_FN pItemFreeFn)
+{
+    if (!pList -> isLinked) //slide the kept items down over the ones taken out
+    {
+        int keptCount = 0;
+        int newCurrentIndex = pList -> currentIndex;
+        for (int i = 0; i < pList -> itemCount; i++)
+        {
+            void * pItem = *ringSlot(pList, i);
+            bool keep = (*pPredicate)(pItem, pContext);
+            if (keep)
+            {
+                *ringSlot(pList, keptCount) = pItem;
+                keptCount++;
+            }
+            else if (pItemFreeFn != NULL)
+            {
+                (*pItemFreeFn)(pItem);
+            }
+            if (i == pList -> currentIndex) //the current item, or the next kept one if it is taken out
+            {
+                newCurrentIndex = keep ? keptCount - 1 : keptCount;
+            }
+        }
+        int removedCount = pList -> itemCount - keptCount;
+        if (pList -> currentIndex >= pList -> itemCount) //beyond the list stays beyond the list
+        {
+            newCurrentIndex = keptCount;
+        }
+        pList -> itemCount = keptCount;
+        reservedNodes -= removedCount;
+        pList -> currentIndex = newCurrentIndex;
+        syncRingPosition(pList);
+        return removedCount;
+    }
+
+    Node * pNode = pList -> head;
+    Node * pLastKept = NULL;
+    bool currentRemoved = false; //current was taken out and no kept node has followed it yet
+    int removedCount = 0;
+
+    for (int i = 0; i < pList -> itemCount; i++)
+    {
+        Node * pNext = pNode -> next;
+        if ((*pPredicate)(pNode -> item, pContext)) //keep it: it is already linked after the last kept node
+        {
+            pNode -> prev = pLastKept;
+            pLastKept = pNode;
+
+            if (currentRemoved) //like List_remove, the next item becomes the current one
+            {
+                pList -> current = pNode;
+                currentRemoved = false;
+            }
+        }
+        else //take it out: unlink it and put the node back into pool of free nodes
+        {
+            publishLink(pLastKept == NULL ? &pList -> head : &pLastKept -> next, pNext);
+            if (pNode == pList -> current)
+            {
+                currentRemoved = true;
+            }
+            releaseNode(pNode);
+            if (pItemFreeFn != NULL)
+            {
+                (*pItemFreeFn)(pNode -> item);
+            }
+            removedCount++;
+        }
+        pNode = pNext;
+    }
+
+    pList -> tail = pLastKept;
+    pList -> itemCount -= removedCount;
+
+    if (pList -> itemCount == 0) //nothing left
+    {
+        pList -> current = NULL;
+        pList -> currentPosition = -1;
+    }
+    else if (currentRemoved) //current was taken out along with everything after it
+    {
+        pList -> current = NULL;
+        pList -> currentPosition = 4;
+    }
+    else if (pList -> current != NULL) //current is still in the list, but the head or tail may have moved
+    {
+        if (pList -> current == pList -> head)
+        {
+            pList -> currentPosition = 1;
+        }
+        else if (pList -> current == pList -> tail)
+        {
+            pList -> currentPosition = 3;
+        }
+        else
+        {
+            pList -> currentPosition = 2;
+        }
+    }
+    return removedCount;
+}
+
+// Replaces every item in pList with (*pMapFn)(item, pContext), from the first to the last.
+// The current pointer is not changed.
+void List_map(List* pList, MAP_FN pMapFn, void* pContext)
+{
+    if (!pList -> isLinked)
+    {
+        for (int i = 0; i < pList -> itemCount; i++)
+        {
+            void ** pSlot = ringSlot(pList, i);
+            *pSlot = (*pMapFn)(*pSlot, pContext);
+        }
+        return;
+    }
+
+    Node * pNode = pList -> head;
+    for (int i = 0; i < pList -> itemCount; i++)
+    {
+        pNode -> item = (*pMapFn)(pNode -> item, pContext);
+        pNode = pNode -> next;
+    }
+    return;
+}
+
+//EPOCH MODE:
+//gives the reader slot of a thread back when the thread exits
+static void releaseReaderSlot(void * pSlot)
+{
+    ReaderSlot * pReader = pSlot;
+    atomic_store_explicit(&pReader -> state, 0, memory_order_release);
+    atomic_store_explicit(&pReader -> claimed, false, memory_order_release);
+    return;
+}
+
+static void createReaderKey()
+{
+    pthread_key_create(&readerKey, releaseReaderSlot);
+    return;
+}
+
+//claims a reader slot for the calling thread, returns false if every slot is held
+static bool claimReaderSlot()
+{
+    pthread_once(&readerKeyOnce, createReaderKey);
+    for (int i = 0; i < LIST_MAX_READERS; i++)
+    {
+        bool expected = false;
+        if (atomic_compare_exchange_strong(&readerSlots[i].claimed, &expected, true))
+        {
+            int slotCount = atomic_load(&readerSlotCount);
+            while (slotCount <= i && !atomic_compare_exchange_weak(&readerSlotCount, &slotCount, i + 1))
+            {
+            }
+            pThreadSlot = &readerSlots[i];
+            pthread_setspecific(readerKey, pThreadSlot);
+            return true;
+        }
+    }
+    return false;
+}
+
+// Turns epoch mode on for the whole pool. Lists in ring form are moved into nodes, since readers 
+// can only walk nodes, and lists created from now on start out as nodes.
+void List_epoch_enable()
+{
+    for (int i = 0; i < nextUnusedHead; i++)
+    {
+        if (!heads[i].isLinked)
+        {
+            convertToNodes(&heads[i]);
+        }
+    }
+    epochMode = true;
+    return;
+}
+
+// Waits until every node taken out so far is back in the pool, then turns epoch mode off.
+void List_epoch_disable()
+{
+    List_epoch_synchronize();
+    epochMode = false;
+    return;
+}
+
+// Waits until no reader can still see a node taken out before the call, and puts those nodes back 
+// into the pool. Must not be called from inside a read-side section.
+void List_epoch_synchronize()
+{
+    while (epochMode && (limbo[0] != NULL || limbo[1] != NULL || limbo[2] != NULL))
+    {
+        if (!tryAdvanceEpoch()) //a reader is still in an older epoch
+        {
+            sched_yield();
+        }
+    }
+    retiredSinceAdvance = 0;
+    return;
+}
+
+// Enters a read-side section on the calling thread. Returns 0 on success, or -1 if 
+// LIST_MAX_READERS threads already hold a reader slot.
+int List_reader_enter()
+{
+    if (pThreadSlot == NULL && !claimReaderSlot())
+    {
+        return -1;
+    }
+    unsigned long epoch = atomic_load_explicit(&globalEpoch, memory_order_acquire);
+    atomic_store_explicit(&pThreadSlot -> state, (epoch << 1) | 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_seq_cst); //the writer sees the slot before this thread reads any link
+    return 0;
+}
+
+// Leaves the read-side section; nodes seen inside it may be handed out again afterwards.
+void List_reader_exit()
+{
+    atomic_store_explicit(&pThreadSlot -> state, 0, memory_order_release);
+    return;
+}
+
+//SNAPSHOTS:
+//the image is a header followed by flat arrays, each starting on an 8 byte boundary:
+//heads[nextUnusedHead], freeHeads[freeHeadCount], links[nextUnusedNode], freeNodes[freeNodeCount], 
+//items[nextUnusedNode], then the items of the lists in ring form, one list after the other
+//every pointer is stored as an index into the pool (-1 for NULL), so the image does not depend on
+//where the pool is mapped, and loading is a single linear pass over each array
+
+#define SNAPSHOT_MAGIC 0x50414e5354534c4cULL //"LLSTSNAP"
+#define SNAPSHOT_VERSION 2
+
+typedef struct SnapshotHeader_s SnapshotHeader;
+struct SnapshotHeader_s
+{
+    uint64_t magic;
+    uint32_t version;
+    uint32_t itemSize;      //bytes stored per item, 0 when the item pointers themselves are stored
+    int32_t nextUnusedHead;
+    int32_t freeHeadCount;
+    int32_t nextUnusedNode;
+    int32_t freeNodeCount;
+};
+
+typedef struct SnapshotHead_s SnapshotHead;
+struct SnapshotHead_s
+{
+    int32_t inUse;          //0 if the head was on the free stack
+    int32_t itemCount;
+    int32_t currentPosition;
+    int32_t head;           //node indices, -1 for NULL (or for a list in ring form)
+    int32_t tail;
+    int32_t current;
+    int32_t isLinked;       //0 for a list in ring form, whose items are stored after the node items
+    int32_t currentIndex;
+};
+
+typedef struct SnapshotLink_s SnapshotLink;
+struct SnapshotLink_s
+{
+    int32_t next;           //node indices, -1 for NULL
+    int32_t prev;
+};
+
+//HELPER FUNCTIONS:
+static size_t alignSection(size_t size)
+{
+    return (size + 7) & ~(size_t) 7;
+}
+
+static int32_t indexOfNode(Node * pNode)
+{
+    return pNode == NULL ? -1 : pNode -> nodeIndex;
+}
+
+static Node * nodeAtIndex(int32_t index)
+{
+    return index < 0 ? NULL : &nodes[index];
+}
+
+//writes size bytes followed by zeroes up to the next 8 byte boundary
+//(only the zeroes if pData is NULL, when the bytes have already been written)
+static bool writeSection(FILE * pFile, const void * pData, size_t size)
+{
+    static const char padding[8] = {0};
+    if (pData != NULL && size > 0 && fwrite(pData, size, 1, pFile) != 1)
+    {
+        return false;
+    }
+    size_t paddingSize = alignSection(size) - size;
+    return paddingSize == 0 || fwrite(padding, paddingSize, 1, pFile) == 1;
+}
+
+//writes one item slot (zeroes if pItem is not in any list)
+static bool writeItem(FILE * pFile, bool isLive, void * pItem, unsigned char * pSlot, size_t itemSize, 
+                      SNAPSHOT_SAVE_FN pSaveFn, void * pContext)
+{
+    size_t itemSlot = itemSize == 0 ? sizeof(uint64_t) : itemSize;
+    memset(pSlot, 0, itemSlot);
+    if (isLive)
+    {
+        if (itemSize == 0)
+        {
+            uint64_t itemValue = (uintptr_t) pItem;
+            memcpy(pSlot, &itemValue, sizeof(itemValue));
+        }
+        else if (pSaveFn != NULL)
+        {
+            (*pSaveFn)(pItem, pSlot, pContext);
+        }
+        else
+        {
+            memcpy(pSlot, pItem, itemSize);
+        }
+    }
+    return fwrite(pSlot, itemSlot, 1, pFile) == 1;
+}
+
+//turns one item slot of the image back into an item
+static void * readItem(char * pSlot, size_t itemSize, SNAPSHOT_LOAD_FN pLoadFn, void * pContext)
+{
+    if (itemSize == 0)
+    {
+        uint64_t itemValue;
+        memcpy(&itemValue, pSlot, sizeof(itemValue));
+        return (void *) (uintptr_t) itemValue;
+    }
+    if (pLoadFn != NULL)
+    {
+        return (*pLoadFn)(pSlot, pContext);
+    }
+    return pSlot;
+}
+
+//true for a node index of the image, or -1 for NULL
+static bool isSnapshotNodeIndex(int32_t index, int32_t nodeCount)
+{
+    return index >= -1 && index < nodeCount;
+}
+
+//walks the linked list of one head of the image, marking its nodes in usedNodes
+static bool checkSnapshotList(const SnapshotHead * pHead, const SnapshotLink * links, int32_t nodeCount,
+                              bool * usedNodes)
+{
+    if (pHead -> itemCount == 0)
+    {
+        return pHead -> head == -1 && pHead -> tail == -1 && pHead -> current == -1
+            && pHead -> currentPosition == -1; //List_next() and List_prev() only expect -1 on an empty list
+    }
+    if (pHead -> itemCount < 0 || pHead -> itemCount > nodeCount || pHead -> currentPosition < 0 || pHead -> currentPosition > 4
+        || (pHead -> current == -1) != (pHead -> currentPosition == 0 || pHead -> currentPosition == 4))
+    {
+        return false;
+    }
+
+    bool currentFound = pHead -> current == -1;
+    int32_t prevIndex = -1;
+    int32_t nodeIndex = pHead -> head;
+    for (int i = 0; i < pHead -> itemCount; i++)
+    {
+        if (nodeIndex < 0 || usedNodes[nodeIndex] || links[nodeIndex].prev != prevIndex)
+        {
+            return false;
+        }
+        usedNodes[nodeIndex] = true;
+        currentFound = currentFound || nodeIndex == pHead -> current;
+        prevIndex = nodeIndex;
+        nodeIndex = links[nodeIndex].next;
+    }
+    if (nodeIndex != -1 || prevIndex != pHead -> tail || !currentFound)
+    {
+        return false;
+    }
+
+    switch (pHead -> currentPosition) //List_next() and List_prev() rely on where current sits
+    {
+        case 1: return pHead -> current == pHead -> head;
+        case 2: return pHead -> current != pHead -> head && pHead -> current != pHead -> tail;
+        case 3: return pHead -> current == pHead -> tail;
+        default: return true;
+    }
+}
+
+//one pass over the index arrays of an image whose section sizes already fit the file, so that
+//loading it cannot leave a pointer outside the pool or a list that does not end
+static bool checkSnapshotIndices(const SnapshotHeader * pHeader, const SnapshotHead * snapshotHeads,
+                                 const int * pFreeHeads, const SnapshotLink * links, const int * pFreeNodes)
+{
+    int32_t nodeCount = pHeader -> nextUnusedNode;
+    int32_t headCount = pHeader -> nextUnusedHead;
+    for (int i = 0; i < nodeCount; i++)
+    {
+        if (!isSnapshotNodeIndex(links[i].next, nodeCount) || !isSnapshotNodeIndex(links[i].prev, nodeCount))
+        {
+            return false;
+        }
+    }
+
+    int freeHeadCount = 0; //the heads not in use must be exactly those on the free stack
+    for (int i = 0; i < headCount; i++)
+    {
+        const SnapshotHead * pHead = &snapshotHeads[i];
+        if (!isSnapshotNodeIndex(pHead -> head, nodeCount) || !isSnapshotNodeIndex(pHead -> tail, nodeCount)
+            || !isSnapshotNodeIndex(pHead -> current, nodeCount))
+        {
+            return false;
+        }
+        freeHeadCount += pHead -> inUse ? 0 : 1;
+    }
+    if (freeHeadCount != pHeader -> freeHeadCount)
+    {
+        return false;
+    }
+    bool freeHeadSeen[LIST_MAX_NUM_HEADS] = {false}; //a head on the stack twice would be handed out twice
+    for (int i = 0; i < pHeader -> freeHeadCount; i++)
+    {
+        if (pFreeHeads[i] < 0 || pFreeHeads[i] >= headCount || snapshotHeads[pFreeHeads[i]].inUse
+            || freeHeadSeen[pFreeHeads[i]])
+        {
+            return false;
+        }
+        freeHeadSeen[pFreeHeads[i]] = true;
+    }
+
+    bool * usedNodes = calloc(nodeCount > 0 ? nodeCount : 1, sizeof(bool));
+    bool valid = usedNodes != NULL;
+    for (int i = 0; valid && i < headCount; i++)
+    {
+        const SnapshotHead * pHead = &snapshotHeads[i];
+        if (pHead -> inUse && pHead -> isLinked)
+        {
+            valid = checkSnapshotList(pHead, links, nodeCount, usedNodes);
+        }
+        else if (pHead -> inUse) //in ring form, the position is worked out again from the index
+        {
+            valid = pHead -> currentIndex >= -1 && pHead -> currentIndex <= pHead -> itemCount;
+        }
+    }
+    for (int i = 0; valid && i < pHeader -> freeNodeCount; i++) //a free node must not also hold an item
+    {
+        valid = pFreeNodes[i] >= 0 && pFreeNodes[i] < nodeCount && !usedNodes[pFreeNodes[i]];
+        if (valid)
+        {
+            usedNodes[pFreeNodes[i]] = true;
+        }
+    }
+    for (int i = 0; valid && i < nodeCount; i++) //and every node is either in a list or free
+    {
+        valid = usedNodes[i];
+    }
+    free(usedNodes);
+    return valid;
+}
+
+// Writes the whole pool to the file at pPath. See list.h for how items are stored.
+// Returns 0 on success, -1 on failure.
+int List_snapshot_save(const char* pPath, size_t itemSize, SNAPSHOT_SAVE_FN pSaveFn, void* pContext)
+{
+    size_t itemSlot = itemSize == 0 ? sizeof(uint64_t) : itemSize;
+    bool * liveNodes = calloc(nextUnusedNode > 0 ? nextUnusedNode : 1, sizeof(bool));
+    SnapshotHead * snapshotHeads = calloc(nextUnusedHead > 0 ? nextUnusedHead : 1, sizeof(SnapshotHead));
+    SnapshotLink * links = malloc((nextUnusedNode > 0 ? nextUnusedNode : 1) * sizeof(SnapshotLink));
+    int * imageFreeNodes = malloc((nextUnusedNode > 0 ? nextUnusedNode : 1) * sizeof(int));
+    unsigned char * pSlot = malloc(itemSlot);
+    FILE * pFile = fopen(pPath, "wb");
+    bool ok = liveNodes != NULL && snapshotHeads != NULL && links != NULL && imageFreeNodes != NULL 
+        && pSlot != NULL && pFile != NULL;
+
+    if (ok)
+    {
+        for (int i = 0; i < nextUnusedHead; i++) //every head handed out is in use unless it was recycled
+        {
+            snapshotHeads[i].inUse = 1;
+        }
+        for (int i = 0; i < freeHeadCount; i++)
+        {
+            snapshotHeads[freeHeads[i]].inUse = 0;
+        }
+
+        size_t ringItemCount = 0;
+        for (int i = 0; i < nextUnusedHead; i++) //mark the nodes that hold items
+        {
+            List * pList = &heads[i];
+            SnapshotHead * pHead = &snapshotHeads[i];
+            pHead -> head = pHead -> tail = pHead -> current = -1;
+            if (!pHead -> inUse)
+            {
+                continue;
+            }
+            pHead -> itemCount = pList -> itemCount;
+            pHead -> currentPosition = pList -> currentPosition;
+            pHead -> isLinked = pList -> isLinked;
+            pHead -> currentIndex = pList -> currentIndex;
+            if (!pList -> isLinked)
+            {
+                ringItemCount += pList -> itemCount;
+                continue;
+            }
+            if (pList -> itemCount != 0)
+            {
+                pHead -> head = indexOfNode(pList -> head);
+                pHead -> tail = indexOfNode(pList -> tail);
+                pHead -> current = indexOfNode(pList -> current);
+            }
+
+            Node * pNode = pList -> head;
+            for (int j = 0; j < pList -> itemCount; j++)
+            {
+                liveNodes[pNode -> nodeIndex] = true;
+                pNode = pNode -> next;
+            }
+        }
+
+        for (int i = 0; i < nextUnusedNode; i++)
+        {
+            links[i].next = liveNodes[i] ? indexOfNode(nodes[i].next) : -1;
+            links[i].prev = liveNodes[i] ? indexOfNode(nodes[i].prev) : -1;
+        }
+
+        //nodes waiting in limbo for readers (epoch mode) are free in the image
+        int imageFreeNodeCount = freeNodeCount;
+        memcpy(imageFreeNodes, freeNodes, freeNodeCount * sizeof(int));
+        for (int i = 0; i < EPOCH_LIMBO_COUNT; i++)
+        {
+            for (Node * pNode = limbo[i]; pNode != NULL; pNode = pNode -> prev)
+            {
+                imageFreeNodes[imageFreeNodeCount++] = pNode -> nodeIndex;
+            }
+        }
+
+        SnapshotHeader header = {SNAPSHOT_MAGIC, SNAPSHOT_VERSION, (uint32_t) itemSize, 
+                                 nextUnusedHead, freeHeadCount, nextUnusedNode, imageFreeNodeCount};
+        ok = writeSection(pFile, &header, sizeof(header))
+            && writeSection(pFile, snapshotHeads, nextUnusedHead * sizeof(SnapshotHead))
+            && writeSection(pFile, freeHeads, freeHeadCount * sizeof(int))
+            && writeSection(pFile, links, nextUnusedNode * sizeof(SnapshotLink))
+            && writeSection(pFile, imageFreeNodes, imageFreeNodeCount * sizeof(int));
+
+        for (int i = 0; ok && i < nextUnusedNode; i++) //node items, one fixed size slot per node
+        {
+            ok = writeItem(pFile, liveNodes[i], nodes[i].item, pSlot, itemSize, pSaveFn, pContext);
+        }
+        ok = ok && writeSection(pFile, NULL, nextUnusedNode * itemSlot); //pad the node items
+
+        for (int i = 0; ok && i < nextUnusedHead; i++) //ring items, list by list
+        {
+            if (!snapshotHeads[i].inUse || heads[i].isLinked)
+            {
+                continue;
+            }
+            for (int j = 0; ok && j < heads[i].itemCount; j++)
+            {
+                ok = writeItem(pFile, true, *ringSlot(&heads[i], j), pSlot, itemSize, pSaveFn, pContext);
+            }
+        }
+        ok = ok && writeSection(pFile, NULL, ringItemCount * itemSlot); //pad the ring items
+    }
+
+    if (pFile != NULL && fclose(pFile) != 0)
+    {
+        ok = false;
+    }
+    free(liveNodes);
+    free(snapshotHeads);
+    free(links);
+    free(imageFreeNodes);
+    free(pSlot);
+    return ok ? 0 : -1;
+}
+
+// Replaces the whole pool with the image in the file at pPath. See list.h for how items are restored.
+// Returns the number of lists restored, or -1 on failure (the pool is left untouched).
+int List_snapshot_load(const char* pPath, List* pLists[LIST_MAX_NUM_HEADS], size_t itemSize, 
+                       SNAPSHOT_LOAD_FN pLoadFn, void* pContext)
+{
+    if (epochMode) //limbo holds nodes of the pool being replaced, and readers may be on them
+    {
+        return -1;
+    }
+    if (firstCreate){
+        if (!mapNodePool())
+        {
+            return -1;
+        }
+        firstCreate = false;
+    }
+
+    int fd = open(pPath, O_RDONLY);
+    if (fd < 0)
+    {
+        return -1;
+    }
+    struct stat fileStat;
+    if (fstat(fd, &fileStat) != 0 || (size_t) fileStat.st_size < sizeof(SnapshotHeader))
+    {
+        close(fd);
+        return -1;
+    }
+    size_t fileSize = (size_t) fileStat.st_size;
+    //private and writable, so items stored in the image can be handed out as they are
+    char * pImage = mmap(NULL, fileSize, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (pImage == MAP_FAILED)
+    {
+        return -1;
+    }
+    madvise(pImage, fileSize, MADV_SEQUENTIAL);
+
+    //check the image fits in this pool before touching anything
+    const SnapshotHeader * pHeader = (const SnapshotHeader *) pImage;
+    size_t itemSlot = itemSize == 0 ? sizeof(uint64_t) : itemSize;
+    bool valid = pHeader -> magic == SNAPSHOT_MAGIC && pHeader -> version == SNAPSHOT_VERSION
+        && pHeader -> itemSize == itemSize
+        && pHeader -> nextUnusedHead >= 0 && pHeader -> nextUnusedHead <= LIST_MAX_NUM_HEADS
+        && pHeader -> freeHeadCount >= 0 && pHeader -> freeHeadCount <= pHeader -> nextUnusedHead
+        && pHeader -> nextUnusedNode >= 0 && pHeader -> nextUnusedNode <= LIST_MAX_NUM_NODES
+        && pHeader -> freeNodeCount >= 0 && pHeader -> freeNodeCount <= pHeader -> nextUnusedNode;
+
+    size_t headsOffset = alignSection(sizeof(SnapshotHeader));
+    size_t freeHeadsOffset = headsOffset + (valid ? alignSection(pHeader -> nextUnusedHead * sizeof(SnapshotHead)) : 0);
+    size_t linksOffset = freeHeadsOffset + (valid ? alignSection(pHeader -> freeHeadCount * sizeof(int)) : 0);
+    size_t freeNodesOffset = linksOffset + (valid ? alignSection(pHeader -> nextUnusedNode * sizeof(SnapshotLink)) : 0);
+    size_t itemsOffset = freeNodesOffset + (valid ? alignSection(pHeader -> freeNodeCount * sizeof(int)) : 0);
+    size_t ringItemsOffset = itemsOffset + (valid ? alignSection(pHeader -> nextUnusedNode * itemSlot) : 0);
+    const SnapshotHead * snapshotHeads = (const SnapshotHead *) (pImage + headsOffset);
+
+    size_t ringItemCount = 0;
+    for (int i = 0; valid && i < pHeader -> nextUnusedHead && freeHeadsOffset <= fileSize; i++)
+    {
+        if (snapshotHeads[i].inUse && !snapshotHeads[i].isLinked)
+        {
+            valid = snapshotHeads[i].itemCount >= 0;
+            ringItemCount += valid ? snapshotHeads[i].itemCount : 0;
+        }
+    }
+    size_t imageSize = ringItemsOffset + alignSection(ringItemCount * itemSlot);
+    valid = valid && imageSize <= fileSize && (int) ringItemCount <= LIST_MAX_NUM_NODES - (pHeader -> nextUnusedNode - pHeader -> freeNodeCount);
+    valid = valid && checkSnapshotIndices(pHeader, snapshotHeads, (const int *) (pImage + freeHeadsOffset),
+                                          (const SnapshotLink *) (pImage + linksOffset),
+                                          (const int *) (pImage + freeNodesOffset));
+
+    //the rings are allocated up front too, so that running out of memory leaves the pool untouched
+    void ** rings[LIST_MAX_NUM_HEADS] = {NULL};
+    int ringCapacities[LIST_MAX_NUM_HEADS] = {0};
+    for (int i = 0; valid && i < pHeader -> nextUnusedHead; i++)
+    {
+        if (snapshotHeads[i].inUse && !snapshotHeads[i].isLinked && snapshotHeads[i].itemCount > 0)
+        {
+            ringCapacities[i] = RING_INITIAL_CAPACITY;
+            while (ringCapacities[i] < snapshotHeads[i].itemCount)
+            {
+                ringCapacities[i] *= 2;
+            }
+            rings[i] = malloc(ringCapacities[i] * sizeof(void *));
+            valid = rings[i] != NULL;
+        }
+    }
+    if (!valid)
+    {
+        for (int i = 0; i < LIST_MAX_NUM_HEADS; i++)
+        {
+            free(rings[i]);
+        }
+        munmap(pImage, fileSize);
+        return -1;
+    }
+
+    const SnapshotLink * links = (const SnapshotLink *) (pImage + linksOffset);
+    char * pItems = pImage + itemsOffset;
+    char * pRingItems = pImage + ringItemsOffset;
+
+    nextUnusedNode = pHeader -> nextUnusedNode;
+    freeNodeCount = pHeader -> freeNodeCount;
+    memcpy(freeNodes, pImage + freeNodesOffset, freeNodeCount * sizeof(int));
+    for (int i = 0; i < nextUnusedNode; i++) //relink the nodes in place, in index order
+    {
+        Node * pNode = &nodes[i];
+        pNode -> nodeIndex = i;
+        pNode -> next = nodeAtIndex(links[i].next);
+        pNode -> prev = nodeAtIndex(links[i].prev);
+        pNode -> item = readItem(pItems + i * itemSlot, itemSize, pLoadFn, pContext);
+    }
+
+    for (int i = 0; i < nextUnusedHead; i++) //the lists in ring form being replaced give their rings back
+    {
+        if (!heads[i].isLinked)
+        {
+            free(heads[i].ring);
+            heads[i].ring = NULL;
+        }
+    }
+
+    nextUnusedHead = pHeader -> nextUnusedHead;
+    freeHeadCount = pHeader -> freeHeadCount;
+    memcpy(freeHeads, pImage + freeHeadsOffset, freeHeadCount * sizeof(int));
+    reservedNodes = (int) ringItemCount;
+    int listCount = 0;
+    for (int i = 0; i < LIST_MAX_NUM_HEADS; i++)
+    {
+        pLists[i] = NULL;
+        if (i >= nextUnusedHead)
+        {
+            continue;
+        }
+        List * pList = &heads[i];
+        pList -> headIndex = i;
+        pList -> itemCount = snapshotHeads[i].itemCount;
+        pList -> currentPosition = snapshotHeads[i].currentPosition;
+        pList -> head = nodeAtIndex(snapshotHeads[i].head);
+        pList -> tail = nodeAtIndex(snapshotHeads[i].tail);
+        pList -> current = nodeAtIndex(snapshotHeads[i].current);
+        pList -> isLinked = snapshotHeads[i].isLinked;
+        pList -> currentIndex = snapshotHeads[i].currentIndex;
+        pList -> ring = rings[i];
+        pList -> ringCapacity = ringCapacities[i];
+        pList -> ringStart = 0;
+        if (!snapshotHeads[i].inUse)
+        {
+            continue;
+        }
+        for (int j = 0; !pList -> isLinked && j < pList -> itemCount; j++)
+        {
+            pList -> ring[j] = readItem(pRingItems, itemSize, pLoadFn, pContext);
+            pRingItems += itemSlot;
+        }
+        if (!pList -> isLinked)
+        {
+            syncRingPosition(pList);
+        }
+        pLists[i] = pList;
+        listCount++;
+    }
+
+    if (itemSize == 0 || pLoadFn != NULL) //the items no longer point into the image
+    {
+        munmap(pImage, fileSize);
+    }
+    return listCount;
+}
@@ -8,6 +8,11 @@
 #ifndef _LIST_H_
 #define _LIST_H_
 #include <stdbool.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
 
 typedef struct Node_s Node;
 struct Node_s
@@ -34,15 +39,51 @@ struct List_s
     Node * head;    //points to first node in the list
     Node * tail;    //points to the last node in the list
     Node * current; //"current" pointer
+
+    //a list starts out in ring form: its items are kept in order in a growable ring buffer, and
+    //head, tail and current stay NULL. The first add, insert or remove in the middle of the list
+    //moves the items into nodes for good (isLinked), so deque-style lists never touch the nodes.
+    bool isLinked;      //false while the list is in ring form
+    void ** ring;       //ring buffer of items (allocated upon the first item)
+    int ringCapacity;   //number of slots in ring, always a power of two
+    int ringStart;      //slot holding the first item
+    int currentIndex;   //in ring form, position of the current item (0 for the first item),
+                        //-1 for before the list and itemCount for past the list
 }; 
 
 // Maximum number of unique lists the system can support
-// (You may modify its value for your needs)
+// (You may modify its value for your needs, or define it when compiling)
+#ifndef LIST_MAX_NUM_HEADS
 #define LIST_MAX_NUM_HEADS 2
+#endif
 
-// Maximum total number of nodes (statically allocated) to be shared across all lists
-// (You may modify its value for your needs)
+// Maximum total number of nodes to be shared across all lists
+// The pool is reserved with mmap upon the first List_create(), and memory is only committed 
+// as nodes are first handed out, so a large pool costs nothing until it is used.
+// (You may modify its value for your needs, or define it when compiling)
+#ifndef LIST_MAX_NUM_NODES
 #define LIST_MAX_NUM_NODES 10
+#endif
+
+// Huge page backing for the node pool, which cuts TLB misses when traversing a large pool:
+// 0 for regular pages only, 1 to ask for transparent huge pages once the pool reaches 2MB,
+// 2 to try reserved huge pages (MAP_HUGETLB) first, falling back to 1 if none are available.
+#ifndef LIST_HUGE_PAGES
+#define LIST_HUGE_PAGES 1
+#endif
+
+// Maximum number of threads that can hold a reader slot at once in epoch mode
+// (You may modify its value for your needs, or define it when compiling)
+#ifndef LIST_MAX_READERS
+#define LIST_MAX_READERS 64
+#endif
+
+// Defining LIST_INLINE_ACCESSORS (before including list.h, or when compiling) turns the trivial
+// accessors List_count and List_curr into static inline functions, so that hot call sites in
+// other modules do not go through a function call. list.c still exports both functions.
+#if defined(LIST_INLINE_ACCESSORS) && !defined(LIST_IMPLEMENTATION)
+#define LIST_ACCESSORS_INLINED
+#endif
 
 // General Error Handling:
 // Client code is assumed never to call these functions with a NULL List pointer, or 
@@ -54,7 +95,14 @@ struct List_s
 List* List_create();
 
 // Returns the number of items in pList.
+#ifdef LIST_ACCESSORS_INLINED
+static inline int List_count(List* pList)
+{
+    return pList -> itemCount;
+}
+#else
 int List_count(List* pList);
+#endif
 
 // Returns a pointer to the first item in pList and makes the first item the current item.
 // Returns NULL and sets current item to NULL if list is empty.
@@ -75,7 +123,22 @@ void* List_next(List* pList);
 void* List_prev(List* pList);
 
 // Returns a pointer to the current item in pList.
+#ifdef LIST_ACCESSORS_INLINED
+static inline void* List_curr(List* pList)
+{
+    if (!pList -> isLinked) //ring form, see List_s
+    {
+        if (pList -> currentIndex < 0 || pList -> currentIndex >= pList -> itemCount)
+        {
+            return NULL;
+        }
+        return pList -> ring[(pList -> ringStart + pList -> currentIndex) & (pList -> ringCapacity - 1)];
+    }
+    return pList -> current == NULL ? NULL : pList -> current -> item;
+}
+#else
 void* List_curr(List* pList);
+#endif
 
 // Adds the new item to pList directly after the current item, and makes item the current item. 
 // If the current pointer is before the start of the pList, the item is added at the start. If 
@@ -111,6 +174,8 @@ void List_concat(List* pList1, List* pList2);
 // It should be invoked (within List_free) as: (*pItemFreeFn)(itemToBeFreedFromNode);
 // pList and all its nodes no longer exists after the operation; its head and nodes are 
 // available for future operations.
+// In epoch mode, pItemFreeFn must not actually free the items while readers may be active
+// (see EPOCH MODE below).
 typedef void (*FREE_FN)(void* pItem);
 void List_free(List* pList, FREE_FN pItemFreeFn);
 
@@ -133,4 +198,125 @@ void* List_trim(List* pList);
 typedef bool (*COMPARATOR_FN)(void* pItem, void* pComparisonArg);
 void* List_search(List* pList, COMPARATOR_FN pComparator, void* pComparisonArg);
 
-#endif
\ No newline at end of file
+// Looks up several keys in a single pass: pResults[i] is set to the first item, searching from the 
+// current item as List_search does, for which (*pComparator)(item, pComparisonArgs[i]) returns 1, 
+// or to NULL if there is none. If pComparator is NULL, an item matches a key if they are the same 
+// pointer, and each item is looked up among the pending keys in a hash table, so the pass costs 
+// O(n + argCount) rather than O(n * argCount). The walk stops as soon as every key has matched.
+// The current pointer is not changed.
+// Returns the number of keys that matched, or -1 on failure (out of memory).
+int List_search_many(List* pList, COMPARATOR_FN pComparator, void* pComparisonArgs[], int argCount, void* pResults[]);
+
+// BULK ITERATION:
+// These walk the nodes directly from the first item to the last, without going through
+// List_next or touching the current pointer once per item.
+
+// Calls (*pVisitFn)(item, pContext) on each item in order, stopping early as soon as it returns false.
+// Returns the item it stopped on, or NULL if every item was visited. The current pointer is not changed.
+typedef bool (*VISIT_FN)(void* pItem, void* pContext);
+void* List_foreach(List* pList, VISIT_FN pVisitFn, void* pContext);
+
+// Takes every item for which (*pPredicate)(item, pContext) returns false out of pList in one pass,
+// calling (*pItemFreeFn)(item) on each of them unless pItemFreeFn is NULL. Kept items stay in order.
+// If the current item is taken out, the next kept item becomes the current one (as in List_remove);
+// if none is left after it, the current pointer is left beyond the end of the list.
+// Returns the number of items taken out. In epoch mode, the same restriction on pItemFreeFn as
+// in List_free applies.
+int List_filter_inplace(List* pList, COMPARATOR_FN pPredicate, void* pContext, FREE_FN pItemFreeFn);
+
+// Replaces every item in pList with (*pMapFn)(item, pContext), in order.
+// The current pointer is not changed. Not allowed while readers are active in epoch mode.
+typedef void* (*MAP_FN)(void* pItem, void* pContext);
+void List_map(List* pList, MAP_FN pMapFn, void* pContext);
+
+// EPOCH MODE (concurrent readers, link with -pthread):
+// Lets any number of threads walk lists with List_foreach while one writer thread changes them, 
+// without the readers taking a lock. Each walk goes inside a read-side section:
+//     if (List_reader_enter() == 0) { List_foreach(pList, pVisitFn, pContext); List_reader_exit(); }
+// A node taken out by the writer is kept (with its item and link to the next node) until every
+// reader that could still be on it has left its section, and only then goes back into the pool.
+// Readers only follow links the writer has finished setting up, so they see each item once, in
+// order, though they may or may not see changes made during their walk.
+// - Only List_foreach and List_reader_* may be called by readers. All other calls (including
+//   List_count, and List_free of a list being read) come from the writer thread, outside any section.
+// - Items taken out may still be in use by readers: free them only after List_epoch_synchronize().
+//   This covers the items handed to pItemFreeFn by List_free and List_filter_inplace.
+// - List_map must not be called while readers are active: it replaces items in place, and readers
+//   could see a new item before what it points to.
+// - Read-side sections must not be nested, and a section should be short: while a reader stays
+//   inside, nodes taken out afterwards are not reused, and List_add and friends may run out of nodes.
+// - Lists stay as nodes while epoch mode is on (see List_s). List_snapshot_save stores the nodes
+//   still kept for readers as free nodes, and List_snapshot_load fails (returns -1) while the mode is on.
+
+// Turns epoch mode on for every list. Call it before readers start.
+void List_epoch_enable();
+
+// Waits until no reader can still see a node taken out before the call, and puts those nodes 
+// back into the pool. Called by the writer, outside any read-side section.
+void List_epoch_synchronize();
+
+// Same as List_epoch_synchronize(), then turns epoch mode off. Call it after readers stop.
+void List_epoch_disable();
+
+// Enters a read-side section on the calling thread. Returns 0 on success, 
+// or -1 if LIST_MAX_READERS other threads already hold a reader slot.
+int List_reader_enter();
+
+// Leaves the read-side section entered by List_reader_enter().
+void List_reader_exit();
+
+// SNAPSHOTS:
+// The whole pool (every list, node and free slot) can be written to a file and loaded back, e.g. 
+// for a fast restart. Links are stored as pool indices, so the image does not depend on where the
+// pool is mapped, and loading maps the file and relinks the nodes in one linear pass instead of
+// rebuilding each list. Images are in the machine's native byte order.
+//
+// Each item is stored in a fixed size slot of itemSize bytes:
+// - itemSize 0 stores the item pointer itself, for items that are not pointers into memory
+//   (such as small integers or indices cast to void*), and restores it as is.
+// - Otherwise the item is written into its slot by (*pSaveFn)(item, slot, pContext), or copied 
+//   from the item's memory if pSaveFn is NULL. On load, each item becomes 
+//   (*pLoadFn)(slot, pContext), where the slot is only valid during the call. If pLoadFn is NULL, 
+//   items point straight into the loaded image, which then stays mapped (copy-on-write).
+
+// Writes the whole pool to the file at pPath. Returns 0 on success, -1 on failure.
+typedef void (*SNAPSHOT_SAVE_FN)(void* pItem, void* pSlot, void* pContext);
+int List_snapshot_save(const char* pPath, size_t itemSize, SNAPSHOT_SAVE_FN pSaveFn, void* pContext);
+
+// Replaces the whole pool with the image at pPath, which must have been saved with the same itemSize.
+// Every List pointer obtained before the call becomes invalid. pLists[i] is set to the list whose
+// headIndex is i, or NULL if no such list was in use when the image was saved.
+// Returns the number of lists restored, or -1 on failure (in which case the pool is left untouched).
+// An image whose node or head indices do not describe well formed lists is a failure too.
+typedef void* (*SNAPSHOT_LOAD_FN)(const void* pSlot, void* pContext);
+int List_snapshot_load(const char* pPath, List* pLists[LIST_MAX_NUM_HEADS], size_t itemSize, 
+                       SNAPSHOT_LOAD_FN pLoadFn, void* pContext);
+
+// PARALLEL OPERATIONS (list_parallel.c, link with -pthread):
+// The list is cut into chunks of consecutive nodes that run on a small pool of worker threads,
+// started upon the first parallel call. The callbacks below run on several threads at once, so
+// they must be thread-safe and must not call back into the list functions. The list must not be
+// modified while a parallel operation runs on it.
+
+// Same as List_search, including where the current pointer is left: the match returned is
+// the first one in list order. The comparator may also be called on items past that match.
+void* List_search_parallel(List* pList, COMPARATOR_FN pComparator, void* pComparisonArg);
+
+// Calls (*pApplyFn)(item, pContext) once on every item in pList, in no particular order.
+// The current pointer is not changed.
+typedef void (*APPLY_FN)(void* pItem, void* pContext);
+void List_foreach_parallel(List* pList, APPLY_FN pApplyFn, void* pContext);
+
+// Folds every item of pList into one value. Each chunk starts from pIdentity and folds its items
+// in order with (*pReduceFn)(accumulator, item, pContext); the chunk results are then folded left
+// to right with (*pCombineFn)(left, right, pContext), so pCombineFn only needs to be associative.
+// Returns pIdentity if pList is empty. The current pointer is not changed.
+typedef void* (*REDUCE_FN)(void* pAccumulator, void* pItem, void* pContext);
+typedef void* (*COMBINE_FN)(void* pLeft, void* pRight, void* pContext);
+void* List_reduce_parallel(List* pList, REDUCE_FN pReduceFn, COMBINE_FN pCombineFn, void* pIdentity, void* pContext);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,440 @@
+//Typed C++ front-end for the list pool (header-only, C++17)
+
+//listfn::List<T, Capacity> follows the same design as list.c: every list of a given T and Capacity
+//shares one statically sized pool of Capacity nodes, handed out from a bump index and a stack of
+//recycled indices. The difference is that each T is stored inline in its node, so walking the list
+//touches no other memory, and that comparators are template parameters, so they can be inlined.
+//Like the C API, running out of nodes is reported through return values rather than exceptions.
+
+#ifndef _LIST_HPP_
+#define _LIST_HPP_
+
+#include <climits>
+#include <cstddef>
+#include <iterator>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include "list.h"
+
+namespace listfn
+{
+
+template <typename T, std::size_t Capacity>
+class List
+{
+    static_assert(Capacity > 0 && Capacity <= INT_MAX, "Capacity must fit the int node indices");
+
+    struct Node
+    {
+        int next;   //index of the next node in the list (not array), -1 for none
+        int prev;   //index of the previous node, -1 for none
+        alignas(T) unsigned char storage[sizeof(T)]; //holds the item in the node
+
+        T * item() { return std::launder(reinterpret_cast<T *>(storage)); }
+    };
+
+    struct Pool
+    {
+        Node nodes[Capacity];
+        int freeNodes[Capacity];    //stack of recycled nodes
+        int freeNodeCount;          //number of nodes on the freeNodes stack
+        int nextUnusedNode;         //index of the first node that has never been handed out
+    };
+
+    static inline Pool pool{};      //shared by every list of this T and Capacity
+
+    int head = -1;
+    int tail = -1;
+    std::size_t itemCount = 0;
+
+    //takes a free node and constructs the item in it, returns -1 if all nodes are used
+    template <typename... Args>
+    static int createNode(Args &&... args)
+    {
+        int index;
+        if (pool.freeNodeCount > 0)
+        {
+            index = pool.freeNodes[--pool.freeNodeCount];
+        }
+        else if (pool.nextUnusedNode < static_cast<int>(Capacity))
+        {
+            index = pool.nextUnusedNode++;
+        }
+        else
+        {
+            return -1;
+        }
+        struct NodeGuard    //gives the node back if the constructor of T throws
+        {
+            int index;
+            ~NodeGuard()
+            {
+                if (index >= 0)
+                {
+                    pool.freeNodes[pool.freeNodeCount++] = index;
+                }
+            }
+        } guard{index};
+        ::new (static_cast<void *>(pool.nodes[index].storage)) T(std::forward<Args>(args)...);
+        guard.index = -1;
+        return index;
+    }
+
+    //destroys the item and puts the node back into the pool
+    static void releaseNode(int index)
+    {
+        pool.nodes[index].item() -> ~T();
+        pool.freeNodes[pool.freeNodeCount++] = index;
+    }
+
+public:
+    template <bool IsConst>
+    class basic_iterator
+    {
+        friend class List;
+        template <bool> friend class basic_iterator;
+        using ListType = std::conditional_t<IsConst, const List, List>;
+
+        int index = -1;             //-1 when past the end
+        ListType * pList = nullptr; //needed to step back from end()
+
+        basic_iterator(int nodeIndex, ListType * list) : index(nodeIndex), pList(list) {}
+
+    public:
+        using iterator_category = std::bidirectional_iterator_tag;
+        using value_type = T;
+        using difference_type = std::ptrdiff_t;
+        using pointer = std::conditional_t<IsConst, const T *, T *>;
+        using reference = std::conditional_t<IsConst, const T &, T &>;
+
+        basic_iterator() = default;
+
+        template <bool OtherConst, typename = std::enable_if_t<IsConst && !OtherConst>>
+        basic_iterator(const basic_iterator<OtherConst> & other) : index(other.index), pList(other.pList) {}
+
+        reference operator*() const { return *pool.nodes[index].item(); }
+        pointer operator->() const { return pool.nodes[index].item(); }
+
+        basic_iterator & operator++()
+        {
+            index = pool.nodes[index].next;
+            return *this;
+        }
+        basic_iterator operator++(int)
+        {
+            basic_iterator old = *this;
+            ++*this;
+            return old;
+        }
+        basic_iterator & operator--()
+        {
+            index = index < 0 ? pList -> tail : pool.nodes[index].prev;
+            return *this;
+        }
+        basic_iterator operator--(int)
+        {
+            basic_iterator old = *this;
+            --*this;
+            return old;
+        }
+
+        friend bool operator==(const basic_iterator & a, const basic_iterator & b) { return a.index == b.index; }
+        friend bool operator!=(const basic_iterator & a, const basic_iterator & b) { return a.index != b.index; }
+    };
+
+    using value_type = T;
+    using size_type = std::size_t;
+    using difference_type = std::ptrdiff_t;
+    using reference = T &;
+    using const_reference = const T &;
+    using iterator = basic_iterator<false>;
+    using const_iterator = basic_iterator<true>;
+
+    // Maximum total number of nodes shared across all lists of this T and Capacity
+    static constexpr std::size_t capacity() { return Capacity; }
+
+    // Returns the number of nodes still free in the shared pool.
+    static std::size_t available() { return pool.freeNodeCount + (Capacity - pool.nextUnusedNode); }
+
+    List() = default;
+    List(const List &) = delete; //a copy could run out of nodes halfway through
+    List & operator=(const List &) = delete;
+
+    // Moving takes the nodes over without touching them; the moved-from list is left empty.
+    List(List && other) noexcept : head(other.head), tail(other.tail), itemCount(other.itemCount)
+    {
+        other.head = other.tail = -1;
+        other.itemCount = 0;
+    }
+    List & operator=(List && other) noexcept
+    {
+        if (this != &other)
+        {
+            clear();
+            std::swap(head, other.head);
+            std::swap(tail, other.tail);
+            std::swap(itemCount, other.itemCount);
+        }
+        return *this;
+    }
+
+    ~List() { clear(); }
+
+    iterator begin() { return iterator(head, this); }
+    iterator end() { return iterator(-1, this); }
+    const_iterator begin() const { return const_iterator(head, this); }
+    const_iterator end() const { return const_iterator(-1, this); }
+    const_iterator cbegin() const { return begin(); }
+    const_iterator cend() const { return end(); }
+
+    std::size_t size() const { return itemCount; }
+    bool empty() const { return itemCount == 0; }
+
+    T & front() { return *pool.nodes[head].item(); }
+    T & back() { return *pool.nodes[tail].item(); }
+    const T & front() const { return *pool.nodes[head].item(); }
+    const T & back() const { return *pool.nodes[tail].item(); }
+
+    // Constructs an item directly before pos (at the end if pos is end()).
+    // Returns an iterator to the new item, or end() if all nodes are used.
+    template <typename... Args>
+    iterator emplace(const_iterator pos, Args &&... args)
+    {
+        int index = createNode(std::forward<Args>(args)...);
+        if (index < 0)
+        {
+            return end();
+        }
+        Node & node = pool.nodes[index];
+        node.next = pos.index;
+        node.prev = pos.index < 0 ? tail : pool.nodes[pos.index].prev;
+        if (node.prev < 0)
+        {
+            head = index;
+        }
+        else
+        {
+            pool.nodes[node.prev].next = index;
+        }
+        if (node.next < 0)
+        {
+            tail = index;
+        }
+        else
+        {
+            pool.nodes[node.next].prev = index;
+        }
+        itemCount++;
+        return iterator(index, this);
+    }
+
+    iterator insert(const_iterator pos, const T & item) { return emplace(pos, item); }
+    iterator insert(const_iterator pos, T && item) { return emplace(pos, std::move(item)); }
+
+    // Add an item to the end/front. Return false if all nodes are used.
+    template <typename... Args>
+    bool emplace_back(Args &&... args) { return emplace(cend(), std::forward<Args>(args)...) != end(); }
+    template <typename... Args>
+    bool emplace_front(Args &&... args) { return emplace(cbegin(), std::forward<Args>(args)...) != end(); }
+    bool push_back(const T & item) { return emplace_back(item); }
+    bool push_back(T && item) { return emplace_back(std::move(item)); }
+    bool push_front(const T & item) { return emplace_front(item); }
+    bool push_front(T && item) { return emplace_front(std::move(item)); }
+
+    // Takes the item at pos out of the list. Returns an iterator to the item after it.
+    iterator erase(const_iterator pos)
+    {
+        Node & node = pool.nodes[pos.index];
+        int next = node.next;
+        if (node.prev < 0)
+        {
+            head = node.next;
+        }
+        else
+        {
+            pool.nodes[node.prev].next = node.next;
+        }
+        if (node.next < 0)
+        {
+            tail = node.prev;
+        }
+        else
+        {
+            pool.nodes[node.next].prev = node.prev;
+        }
+        releaseNode(pos.index);
+        itemCount--;
+        return iterator(next, this);
+    }
+
+    // Take the last/first item out of the list. Return false if the list is empty.
+    bool pop_back()
+    {
+        if (itemCount == 0)
+        {
+            return false;
+        }
+        erase(const_iterator(tail, this));
+        return true;
+    }
+    bool pop_front()
+    {
+        if (itemCount == 0)
+        {
+            return false;
+        }
+        erase(cbegin());
+        return true;
+    }
+
+    // Takes every item out of the list and puts the nodes back into the pool.
+    void clear()
+    {
+        for (int index = head; index >= 0;)
+        {
+            int next = pool.nodes[index].next;
+            releaseNode(index);
+            index = next;
+        }
+        head = tail = -1;
+        itemCount = 0;
+    }
+
+    // Adds the items of other to the end of this list; other is left empty. No nodes are copied.
+    void concat(List & other)
+    {
+        if (&other == this || other.itemCount == 0)
+        {
+            return;
+        }
+        if (itemCount == 0)
+        {
+            head = other.head;
+        }
+        else
+        {
+            pool.nodes[tail].next = other.head;
+            pool.nodes[other.head].prev = tail;
+        }
+        tail = other.tail;
+        itemCount += other.itemCount;
+        other.head = other.tail = -1;
+        other.itemCount = 0;
+    }
+
+    // Same idea as List_search: starting at from, returns the first item for which
+    // comparator(item, comparisonArg) is true, or end() if there is none.
+    template <typename Comparator, typename Arg>
+    iterator search(const_iterator from, Comparator && comparator, const Arg & comparisonArg)
+    {
+        for (int index = from.index; index >= 0; index = pool.nodes[index].next)
+        {
+            if (comparator(*pool.nodes[index].item(), comparisonArg))
+            {
+                return iterator(index, this);
+            }
+        }
+        return end();
+    }
+
+    // Appends a pointer to every item, in order, to the C list pList, so that the items can be
+    // handed to code using the C API. The pointers stay valid until the items are erased.
+    // Returns false if the C pool ran out of nodes (the items appended so far stay in pList).
+    bool append_to(::List * pList)
+    {
+        for (T & item : *this)
+        {
+            if (List_append(pList, static_cast<void *>(std::addressof(item))) != 0)
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+};
+
+// Bidirectional view over a C list whose items all point to T, for using the C lists with
+// range-for and the std algorithms. Works on lists in either form (see List_s).
+// The view does not touch the list's current pointer.
+template <typename T>
+class CListView
+{
+    ::List * pList;
+
+public:
+    class iterator
+    {
+        ::List * pList = nullptr;   //needed to step back from end()
+        int index = 0;              //position in the list, itemCount when past the end
+        ::Node * pNode = nullptr;   //node at index once the list is linked, nullptr when past the end
+
+        void * item() const
+        {
+            if (pList -> isLinked)
+            {
+                return pNode -> item;
+            }
+            return pList -> ring[(pList -> ringStart + index) & (pList -> ringCapacity - 1)];
+        }
+
+    public:
+        using iterator_category = std::bidirectional_iterator_tag;
+        using value_type = T;
+        using difference_type = std::ptrdiff_t;
+        using pointer = T *;
+        using reference = T &;
+
+        iterator() = default;
+        iterator(::List * list, int position, ::Node * node) : pList(list), index(position), pNode(node) {}
+
+        T & operator*() const { return *static_cast<T *>(item()); }
+        T * operator->() const { return static_cast<T *>(item()); }
+        T * get() const { return static_cast<T *>(item()); }
+
+        iterator & operator++()
+        {
+            if (pList -> isLinked)
+            {
+                pNode = pNode == pList -> tail ? nullptr : pNode -> next;
+            }
+            index++;
+            return *this;
+        }
+        iterator operator++(int)
+        {
+            iterator old = *this;
+            ++*this;
+            return old;
+        }
+        iterator & operator--()
+        {
+            if (pList -> isLinked)
+            {
+                pNode = pNode == nullptr ? pList -> tail : pNode -> prev;
+            }
+            index--;
+            return *this;
+        }
+        iterator operator--(int)
+        {
+            iterator old = *this;
+            --*this;
+            return old;
+        }
+
+        friend bool operator==(const iterator & a, const iterator & b) { return a.index == b.index; }
+        friend bool operator!=(const iterator & a, const iterator & b) { return a.index != b.index; }
+    };
+
+    explicit CListView(::List * list) : pList(list) {}
+
+    iterator begin() const { return iterator(pList, 0, pList -> itemCount == 0 ? nullptr : pList -> head); }
+    iterator end() const { return iterator(pList, pList -> itemCount, nullptr); }
+    std::size_t size() const { return static_cast<std::size_t>(List_count(pList)); }
+    bool empty() const { return size() == 0; }
+};
+
+}
+
+#endif
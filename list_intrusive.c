@@ -0,0 +1,275 @@
+//Intrusive flavour of the list functions
+//Items embed their own ListHook, so no node is ever taken from the pool
+
+#include <stdbool.h>
+#include <stddef.h>
+#include "list_intrusive.h"
+
+//HELPER FUNCTIONS:
+//links pHook in between pPrev and pNext (either may be NULL) and makes it the current item
+static void linkHook(ListIntrusive * pList, ListHook * pHook, ListHook * pPrev, ListHook * pNext)
+{
+    pHook -> prev = pPrev;
+    pHook -> next = pNext;
+    if (pPrev == NULL)
+    {
+        pList -> head = pHook;
+    }
+    else
+    {
+        pPrev -> next = pHook;
+    }
+    if (pNext == NULL)
+    {
+        pList -> tail = pHook;
+    }
+    else
+    {
+        pNext -> prev = pHook;
+    }
+    pList -> current = pHook;
+    pList -> itemCount++;
+    return;
+}
+
+//takes pHook out of the list, without touching the current pointer
+static void unlinkHook(ListIntrusive * pList, ListHook * pHook)
+{
+    if (pHook -> prev == NULL)
+    {
+        pList -> head = pHook -> next;
+    }
+    else
+    {
+        pHook -> prev -> next = pHook -> next;
+    }
+    if (pHook -> next == NULL)
+    {
+        pList -> tail = pHook -> prev;
+    }
+    else
+    {
+        pHook -> next -> prev = pHook -> prev;
+    }
+    pHook -> next = NULL;
+    pHook -> prev = NULL;
+    pList -> itemCount--;
+    return;
+}
+
+// Makes pList an empty list.
+void ListIntrusive_init(ListIntrusive* pList)
+{
+    pList -> itemCount = 0;
+    pList -> beyondEnd = false;
+    pList -> head = NULL;
+    pList -> tail = NULL;
+    pList -> current = NULL;
+    return;
+}
+
+// Returns the number of items in pList.
+int ListIntrusive_count(ListIntrusive* pList)
+{
+    return pList -> itemCount;
+}
+
+// Returns the first item in pList and makes it the current item.
+// Returns NULL if list is empty.
+ListHook* ListIntrusive_first(ListIntrusive* pList)
+{
+    if (pList -> itemCount == 0)
+    {
+        return NULL;
+    }
+    pList -> current = pList -> head;
+    return pList -> current;
+}
+
+// Returns the last item in pList and makes it the current item.
+// Returns NULL if list is empty.
+ListHook* ListIntrusive_last(ListIntrusive* pList)
+{
+    if (pList -> itemCount == 0)
+    {
+        return NULL;
+    }
+    pList -> current = pList -> tail;
+    return pList -> current;
+}
+
+// Advances pList's current item by one, and returns the new current item.
+// Past the end, returns NULL and leaves the current item beyond the end of pList.
+ListHook* ListIntrusive_next(ListIntrusive* pList)
+{
+    if (pList -> current != NULL)
+    {
+        pList -> current = pList -> current -> next;
+    }
+    else if (!pList -> beyondEnd) //before the start, move onto the head
+    {
+        pList -> current = pList -> head;
+    }
+
+    if (pList -> current == NULL)
+    {
+        pList -> beyondEnd = true;
+    }
+    return pList -> current;
+}
+
+// Backs up pList's current item by one, and returns the new current item.
+// Past the start, returns NULL and leaves the current item before the start of pList.
+ListHook* ListIntrusive_prev(ListIntrusive* pList)
+{
+    if (pList -> current != NULL)
+    {
+        pList -> current = pList -> current -> prev;
+    }
+    else if (pList -> beyondEnd) //beyond the end, move onto the tail
+    {
+        pList -> current = pList -> tail;
+    }
+
+    if (pList -> current == NULL)
+    {
+        pList -> beyondEnd = false;
+    }
+    return pList -> current;
+}
+
+// Returns the current item in pList.
+ListHook* ListIntrusive_curr(ListIntrusive* pList)
+{
+    return pList -> current;
+}
+
+// Adds pHook directly after the current item, and makes it the current item.
+// Before the start it is added at the start, beyond the end it is added at the end.
+void ListIntrusive_add(ListIntrusive* pList, ListHook* pHook)
+{
+    if (pList -> current != NULL)
+    {
+        linkHook(pList, pHook, pList -> current, pList -> current -> next);
+    }
+    else if (pList -> beyondEnd)
+    {
+        linkHook(pList, pHook, pList -> tail, NULL);
+    }
+    else
+    {
+        linkHook(pList, pHook, NULL, pList -> head);
+    }
+    return;
+}
+
+// Adds pHook directly before the current item, and makes it the current item.
+// Before the start it is added at the start, beyond the end it is added at the end.
+void ListIntrusive_insert(ListIntrusive* pList, ListHook* pHook)
+{
+    if (pList -> current != NULL)
+    {
+        linkHook(pList, pHook, pList -> current -> prev, pList -> current);
+    }
+    else if (pList -> beyondEnd)
+    {
+        linkHook(pList, pHook, pList -> tail, NULL);
+    }
+    else
+    {
+        linkHook(pList, pHook, NULL, pList -> head);
+    }
+    return;
+}
+
+// Adds pHook to the end of pList, and makes it the current item.
+void ListIntrusive_append(ListIntrusive* pList, ListHook* pHook)
+{
+    linkHook(pList, pHook, pList -> tail, NULL);
+    return;
+}
+
+// Adds pHook to the front of pList, and makes it the current item.
+void ListIntrusive_prepend(ListIntrusive* pList, ListHook* pHook)
+{
+    linkHook(pList, pHook, NULL, pList -> head);
+    return;
+}
+
+// Returns the current item and takes it out of pList. Makes the next item the current one.
+// If the current pointer is before the start or beyond the end, does nothing and returns NULL.
+ListHook* ListIntrusive_remove(ListIntrusive* pList)
+{
+    ListHook * pHook = pList -> current;
+    if (pHook == NULL)
+    {
+        return NULL;
+    }
+
+    pList -> current = pHook -> next;
+    if (pList -> current == NULL)
+    {
+        pList -> beyondEnd = true;
+    }
+    unlinkHook(pList, pHook);
+    return pHook;
+}
+
+// Returns the last item and takes it out of pList. Makes the new last item the current one.
+// Returns NULL if pList is empty.
+ListHook* ListIntrusive_trim(ListIntrusive* pList)
+{
+    ListHook * pHook = pList -> tail;
+    if (pHook == NULL)
+    {
+        return NULL;
+    }
+
+    unlinkHook(pList, pHook);
+    pList -> current = pList -> tail;
+    pList -> beyondEnd = false;
+    return pHook;
+}
+
+// Adds pList2 to the end of pList1. pList2 is left empty.
+void ListIntrusive_concat(ListIntrusive* pList1, ListIntrusive* pList2)
+{
+    if (pList2 -> itemCount != 0) //if second list is empty, do nothing
+    {
+        if (pList1 -> itemCount == 0)
+        {
+            pList1 -> head = pList2 -> head;
+        }
+        else
+        {
+            pList1 -> tail -> next = pList2 -> head;
+            pList2 -> head -> prev = pList1 -> tail;
+        }
+        pList1 -> tail = pList2 -> tail;
+        pList1 -> itemCount += pList2 -> itemCount;
+    }
+    ListIntrusive_init(pList2);
+    return;
+}
+
+// Searches pList from the current item (or the first item, if before the start) for a match.
+// If a match is found, it becomes the current item and is returned. Otherwise the current 
+// pointer is left beyond the end of the list and NULL is returned.
+ListHook* ListIntrusive_search(ListIntrusive* pList, HOOK_COMPARATOR_FN pComparator, void* pComparisonArg)
+{
+    if (pList -> current == NULL && !pList -> beyondEnd)
+    {
+        pList -> current = pList -> head; //if before list, then start at head
+    }
+
+    while (pList -> current != NULL)
+    {
+        if ((*pComparator)(pList -> current, pComparisonArg))
+        {
+            return pList -> current;
+        }
+        pList -> current = pList -> current -> next;
+    }
+    pList -> beyondEnd = true;
+    return NULL;
+}
@@ -0,0 +1,76 @@
+//Intrusive flavour of the list functions
+
+//Instead of taking a node from the pool for every item, each item struct embeds a ListHook, 
+//and the list links the hooks together. Adding an item can therefore never fail, there is no 
+//limit on the number of items, and walking a list touches only the items themselves.
+//The current pointer behaves as in list.h.
+
+#ifndef _LIST_INTRUSIVE_H_
+#define _LIST_INTRUSIVE_H_
+#include <stdbool.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct ListHook_s ListHook;
+struct ListHook_s
+{
+    ListHook * next;    //hook of the next item in the list
+    ListHook * prev;    //hook of the previous item
+};
+
+typedef struct ListIntrusive_s ListIntrusive;
+struct ListIntrusive_s
+{
+    int itemCount;      //how many items are in the list
+    bool beyondEnd;     //when current is NULL: true if it is beyond the end of the list, false if before the start
+    ListHook * head;    //hook of the first item in the list
+    ListHook * tail;    //hook of the last item in the list
+    ListHook * current; //"current" pointer
+};
+
+// Returns the struct of type type that embeds pHook as its member member, e.g.
+// struct Job * pJob = LIST_ENTRY(ListIntrusive_curr(&jobs), struct Job, hook);
+#define LIST_ENTRY(pHook, type, member) ((type *) ((char *) (pHook) - offsetof(type, member)))
+
+// A hook can only be in one list at a time. Client code is assumed never to add a hook that is 
+// already in a list, or to pass a NULL list or hook.
+
+// Makes pList an empty list. The list needs no other setup or teardown.
+void ListIntrusive_init(ListIntrusive* pList);
+
+// Returns the number of items in pList.
+int ListIntrusive_count(ListIntrusive* pList);
+
+// Same as List_first, List_last, List_next, List_prev and List_curr, on hooks.
+ListHook* ListIntrusive_first(ListIntrusive* pList);
+ListHook* ListIntrusive_last(ListIntrusive* pList);
+ListHook* ListIntrusive_next(ListIntrusive* pList);
+ListHook* ListIntrusive_prev(ListIntrusive* pList);
+ListHook* ListIntrusive_curr(ListIntrusive* pList);
+
+// Same as List_add, List_insert, List_append and List_prepend, except that they cannot fail.
+void ListIntrusive_add(ListIntrusive* pList, ListHook* pHook);
+void ListIntrusive_insert(ListIntrusive* pList, ListHook* pHook);
+void ListIntrusive_append(ListIntrusive* pList, ListHook* pHook);
+void ListIntrusive_prepend(ListIntrusive* pList, ListHook* pHook);
+
+// Same as List_remove and List_trim. The hook taken out can be added to a list again.
+ListHook* ListIntrusive_remove(ListIntrusive* pList);
+ListHook* ListIntrusive_trim(ListIntrusive* pList);
+
+// Adds pList2 to the end of pList1. The current pointer is set to the current pointer of pList1.
+// pList2 is left empty.
+void ListIntrusive_concat(ListIntrusive* pList1, ListIntrusive* pList2);
+
+// Same as List_search, with a comparator that takes the item's hook.
+typedef bool (*HOOK_COMPARATOR_FN)(ListHook* pHook, void* pComparisonArg);
+ListHook* ListIntrusive_search(ListIntrusive* pList, HOOK_COMPARATOR_FN pComparator, void* pComparisonArg);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
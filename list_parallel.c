@@ -0,0 +1,389 @@
+//Parallel search, foreach and reduce over one list
+
+//The list is cut into chunks of consecutive items (index ranges for a list in ring form,
+//found by walking the node chain once otherwise), then the chunks are handed to a small
+//pool of worker threads.
+//Every thread (the caller included) keeps claiming the next unclaimed chunk until
+//none are left, so a thread stuck on an expensive chunk never holds up the others.
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <pthread.h>
+#include <unistd.h>
+#include "list.h"
+
+// Upper bound on threads (caller included) working on one operation
+#ifndef LIST_PARALLEL_MAX_THREADS
+#define LIST_PARALLEL_MAX_THREADS 8
+#endif
+
+// Threads used per operation, 0 means one per online CPU (capped by LIST_PARALLEL_MAX_THREADS)
+#ifndef LIST_PARALLEL_THREADS
+#define LIST_PARALLEL_THREADS 0
+#endif
+
+#define CHUNKS_PER_THREAD 4 //more chunks than threads so idle threads have something left to claim
+#define MAX_CHUNKS (LIST_PARALLEL_MAX_THREADS * CHUNKS_PER_THREAD)
+
+typedef struct Job_s Job;
+struct Job_s
+{
+    List * pList;
+    int chunkCount;
+    Node * chunkStart[MAX_CHUNKS];  //first node of each chunk (NULL in ring form)
+    int chunkStartIndex[MAX_CHUNKS];//position of the first item of each chunk in the ring
+    int chunkLength[MAX_CHUNKS];    //number of items in each chunk
+    atomic_int nextChunk;           //next chunk nobody has claimed yet
+    void (*runChunk)(Job * pJob, int chunk);
+
+    void * pContext;
+    COMPARATOR_FN pComparator;      //search
+    atomic_int firstMatchChunk;     //lowest chunk that has found a match, chunkCount if none
+    Node * chunkMatch[MAX_CHUNKS];  //matching node, or for ring form:
+    int chunkMatchIndex[MAX_CHUNKS];//position of the matching item
+    APPLY_FN pApplyFn;              //foreach
+    REDUCE_FN pReduceFn;            //reduce
+    void * pIdentity;
+    void * chunkResult[MAX_CHUNKS];
+};
+
+static pthread_once_t poolOnce = PTHREAD_ONCE_INIT;
+static pthread_mutex_t jobLock = PTHREAD_MUTEX_INITIALIZER;  //only one job runs on the pool at a time
+static pthread_mutex_t poolLock = PTHREAD_MUTEX_INITIALIZER; //guards the fields below
+static pthread_cond_t jobPosted = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t jobFinished = PTHREAD_COND_INITIALIZER;
+
+static int workerCount = 0;             //threads in the pool, not counting the caller
+static Job * postedJob = NULL;
+static unsigned long jobGeneration = 0; //bumped every time a job is posted
+static int busyWorkers = 0;             //workers that have not finished the posted job
+
+//HELPER FUNCTIONS:
+//claims and runs chunks until there are none left
+static void runChunks(Job * pJob)
+{
+    int chunk;
+    while ((chunk = atomic_fetch_add(&pJob -> nextChunk, 1)) < pJob -> chunkCount)
+    {
+        pJob -> runChunk(pJob, chunk);
+    }
+    return;
+}
+
+static void * workerMain(void * unused)
+{
+    (void) unused;
+    unsigned long seenGeneration = 0;
+
+    pthread_mutex_lock(&poolLock);
+    while (true)
+    {
+        while (jobGeneration == seenGeneration) //sleep until a new job shows up
+        {
+            pthread_cond_wait(&jobPosted, &poolLock);
+        }
+        seenGeneration = jobGeneration;
+        Job * pJob = postedJob;
+        pthread_mutex_unlock(&poolLock);
+
+        runChunks(pJob);
+
+        pthread_mutex_lock(&poolLock);
+        busyWorkers--;
+        if (busyWorkers == 0)
+        {
+            pthread_cond_signal(&jobFinished);
+        }
+    }
+    return NULL;
+}
+
+//starts the workers upon the first parallel call
+static void initializePool()
+{
+    int threads = LIST_PARALLEL_THREADS;
+    if (threads <= 0)
+    {
+        threads = (int) sysconf(_SC_NPROCESSORS_ONLN);
+    }
+    if (threads > LIST_PARALLEL_MAX_THREADS)
+    {
+        threads = LIST_PARALLEL_MAX_THREADS;
+    }
+
+    for (int i = 0; i < threads - 1; i++) //the caller is the last thread
+    {
+        pthread_t thread;
+        if (pthread_create(&thread, NULL, workerMain, NULL) != 0) //make do with the workers we have
+        {
+            break;
+        }
+        pthread_detach(thread);
+        workerCount++;
+    }
+    return;
+}
+
+//cuts the items of pList from position startIndex on (or from pStartNode on, for a list of nodes) into chunks
+static void partitionList(Job * pJob, List * pList, Node * pStartNode, int startIndex)
+{
+    int targetChunks = (workerCount + 1) * CHUNKS_PER_THREAD;
+    int maxItems; //items from the start point to the end of the list, which the chunks split between them
+    if (!pList -> isLinked)
+    {
+        maxItems = pList -> itemCount - startIndex;
+    }
+    else if (pStartNode == pList -> head)
+    {
+        maxItems = pList -> itemCount;
+    }
+    else //starting in the middle: count what is left, or a late start would get only a chunk or two
+    {
+        maxItems = 0;
+        for (Node * pNode = pStartNode; pNode != NULL; pNode = pNode -> next)
+        {
+            maxItems++;
+        }
+    }
+    int chunkSize = (maxItems + targetChunks - 1) / targetChunks;
+    if (chunkSize < 1)
+    {
+        chunkSize = 1;
+    }
+
+    pJob -> pList = pList;
+    pJob -> chunkCount = 0;
+    if (!pList -> isLinked) //ring form: the chunks are just index ranges
+    {
+        for (int index = startIndex; index < pList -> itemCount; index += chunkSize)
+        {
+            pJob -> chunkStart[pJob -> chunkCount] = NULL;
+            pJob -> chunkStartIndex[pJob -> chunkCount] = index;
+            pJob -> chunkLength[pJob -> chunkCount] = index + chunkSize <= pList -> itemCount ? chunkSize : pList -> itemCount - index;
+            pJob -> chunkCount++;
+        }
+        atomic_init(&pJob -> nextChunk, 0);
+        return;
+    }
+
+    int filled = 0; //nodes already placed in the current chunk
+    Node * pNode = pStartNode;
+    for (int i = 0; i < maxItems && pNode != NULL; i++, pNode = pNode -> next)
+    {
+        if (filled == 0) //start a new chunk
+        {
+            pJob -> chunkStart[pJob -> chunkCount] = pNode;
+            pJob -> chunkStartIndex[pJob -> chunkCount] = 0; //unused for nodes
+            pJob -> chunkLength[pJob -> chunkCount] = 0;
+            pJob -> chunkCount++;
+        }
+        pJob -> chunkLength[pJob -> chunkCount - 1]++;
+        filled++;
+        if (filled == chunkSize)
+        {
+            filled = 0;
+        }
+    }
+    atomic_init(&pJob -> nextChunk, 0);
+    return;
+}
+
+//returns the item at offset i of chunk, where pNode is the node holding it (for a list of nodes)
+static void * chunkItem(Job * pJob, int chunk, int i, Node * pNode)
+{
+    if (pNode != NULL)
+    {
+        return pNode -> item;
+    }
+    List * pList = pJob -> pList;
+    return pList -> ring[(pList -> ringStart + pJob -> chunkStartIndex[chunk] + i) & (pList -> ringCapacity - 1)];
+}
+
+//runs pJob on the pool and returns once every chunk is done
+static void runJob(Job * pJob)
+{
+    if (workerCount == 0 || pJob -> chunkCount < 2) //nothing to gain from waking the workers
+    {
+        runChunks(pJob);
+        return;
+    }
+
+    pthread_mutex_lock(&jobLock);
+
+    pthread_mutex_lock(&poolLock);
+    postedJob = pJob;
+    jobGeneration++;
+    busyWorkers = workerCount;
+    pthread_cond_broadcast(&jobPosted);
+    pthread_mutex_unlock(&poolLock);
+
+    runChunks(pJob); //the caller works too
+
+    pthread_mutex_lock(&poolLock);
+    while (busyWorkers > 0)
+    {
+        pthread_cond_wait(&jobFinished, &poolLock);
+    }
+    postedJob = NULL;
+    pthread_mutex_unlock(&poolLock);
+
+    pthread_mutex_unlock(&jobLock);
+    return;
+}
+
+static void searchChunk(Job * pJob, int chunk)
+{
+    Node * pNode = pJob -> chunkStart[chunk];
+    for (int i = 0; i < pJob -> chunkLength[chunk]; i++)
+    {
+        if (atomic_load_explicit(&pJob -> firstMatchChunk, memory_order_relaxed) < chunk) //an earlier chunk already matched
+        {
+            return;
+        }
+        if ((*pJob -> pComparator)(chunkItem(pJob, chunk, i, pNode), pJob -> pContext))
+        {
+            pJob -> chunkMatch[chunk] = pNode;
+            pJob -> chunkMatchIndex[chunk] = pJob -> chunkStartIndex[chunk] + i;
+            int best = atomic_load(&pJob -> firstMatchChunk);
+            while (chunk < best && !atomic_compare_exchange_weak(&pJob -> firstMatchChunk, &best, chunk))
+            {
+            }
+            return;
+        }
+        if (pNode != NULL)
+        {
+            pNode = pNode -> next;
+        }
+    }
+    return;
+}
+
+static void foreachChunk(Job * pJob, int chunk)
+{
+    Node * pNode = pJob -> chunkStart[chunk];
+    for (int i = 0; i < pJob -> chunkLength[chunk]; i++)
+    {
+        (*pJob -> pApplyFn)(chunkItem(pJob, chunk, i, pNode), pJob -> pContext);
+        if (pNode != NULL)
+        {
+            pNode = pNode -> next;
+        }
+    }
+    return;
+}
+
+static void reduceChunk(Job * pJob, int chunk)
+{
+    Node * pNode = pJob -> chunkStart[chunk];
+    void * pAccumulator = pJob -> pIdentity;
+    for (int i = 0; i < pJob -> chunkLength[chunk]; i++)
+    {
+        pAccumulator = (*pJob -> pReduceFn)(pAccumulator, chunkItem(pJob, chunk, i, pNode), pJob -> pContext);
+        if (pNode != NULL)
+        {
+            pNode = pNode -> next;
+        }
+    }
+    pJob -> chunkResult[chunk] = pAccumulator;
+    return;
+}
+
+// Same as List_search, but the comparator runs on several threads at once.
+void* List_search_parallel(List* pList, COMPARATOR_FN pComparator, void* pComparisonArg)
+{
+    Node * pStart;
+    switch (pList -> currentPosition)
+    {
+        case 0:
+            pStart = pList -> head; //if before list, then start at head
+            break;
+        case 1:
+        case 2:
+        case 3:
+            pStart = pList -> current; //NULL in ring form, which starts from currentIndex instead
+            break;
+        default:
+            return NULL;
+    }
+
+    pthread_once(&poolOnce, initializePool);
+
+    Job job;
+    job.runChunk = searchChunk;
+    job.pComparator = pComparator;
+    job.pContext = pComparisonArg;
+    partitionList(&job, pList, pStart, pList -> currentIndex < 0 ? 0 : pList -> currentIndex);
+    atomic_init(&job.firstMatchChunk, job.chunkCount);
+
+    runJob(&job);
+
+    int matchChunk = atomic_load(&job.firstMatchChunk);
+    if (matchChunk == job.chunkCount) //no match, leave current beyond the list
+    {
+        pList -> current = NULL;
+        pList -> currentIndex = pList -> itemCount;
+        pList -> currentPosition = 4;
+        return NULL;
+    }
+
+    if (!pList -> isLinked)
+    {
+        int index = job.chunkMatchIndex[matchChunk];
+        pList -> currentIndex = index;
+        pList -> currentPosition = index == 0 ? 1 : (index == pList -> itemCount - 1 ? 3 : 2);
+        return pList -> ring[(pList -> ringStart + index) & (pList -> ringCapacity - 1)];
+    }
+
+    pList -> current = job.chunkMatch[matchChunk];
+    if (pList -> current == pList -> head)
+    {
+        pList -> currentPosition = 1;
+    }
+    else if (pList -> current == pList -> tail)
+    {
+        pList -> currentPosition = 3;
+    }
+    else
+    {
+        pList -> currentPosition = 2;
+    }
+    return pList -> current -> item;
+}
+
+// Calls pApplyFn on every item in pList, several items at once.
+void List_foreach_parallel(List* pList, APPLY_FN pApplyFn, void* pContext)
+{
+    pthread_once(&poolOnce, initializePool);
+
+    Job job;
+    job.runChunk = foreachChunk;
+    job.pApplyFn = pApplyFn;
+    job.pContext = pContext;
+    partitionList(&job, pList, pList -> head, 0);
+
+    runJob(&job);
+    return;
+}
+
+// Folds every item of pList into one value, several chunks at once.
+void* List_reduce_parallel(List* pList, REDUCE_FN pReduceFn, COMBINE_FN pCombineFn, void* pIdentity, void* pContext)
+{
+    pthread_once(&poolOnce, initializePool);
+
+    Job job;
+    job.runChunk = reduceChunk;
+    job.pReduceFn = pReduceFn;
+    job.pIdentity = pIdentity;
+    job.pContext = pContext;
+    partitionList(&job, pList, pList -> head, 0);
+
+    runJob(&job);
+
+    void * pResult = pIdentity;
+    for (int chunk = 0; chunk < job.chunkCount; chunk++) //combine in list order
+    {
+        pResult = (*pCombineFn)(pResult, job.chunkResult[chunk], pContext);
+    }
+    return pResult;
+}
@@ -3,10 +3,13 @@
  */
 
 #include "list.h"
+#include "list_intrusive.h"
 #include <stdio.h>
 #include <assert.h>
 #include <string.h>
 #include <stdlib.h>
+#include <pthread.h>
+#include <sched.h>
 
 // Macro for custom testing; does exit(1) on failure.
 #define CHECK(condition) do{ \
@@ -30,6 +33,684 @@ static bool itemEquals(void* pItem, void* pArg)
     return (pItem == pArg);
 }
 
+// For the parallel tests: items are ints, matched on value rather than address
+static bool valueEquals(void* pItem, void* pArg)
+{
+    return *(int*)pItem == *(int*)pArg;
+}
+
+static void addValue(void* pItem, void* pContext)
+{
+    __atomic_fetch_add((int*)pContext, *(int*)pItem, __ATOMIC_RELAXED);
+}
+
+static void* sumValues(void* pAccumulator, void* pItem, void* pContext)
+{
+    return (void*)((long)pAccumulator + *(int*)pItem);
+}
+
+static void* sumResults(void* pLeft, void* pRight, void* pContext)
+{
+    return (void*)((long)pLeft + (long)pRight);
+}
+
+static void testParallel()
+{
+    List * list = List_create();
+    int values[10] = {1, 2, 3, 4, 5, 3, 7, 8, 3, 10};
+    int three = 3;
+    int eleven = 11;
+
+    CHECK(List_search_parallel(list, valueEquals, &three) == NULL); //empty list
+    for (int i = 0; i < 10; i++)
+    {
+        CHECK(List_append(list, &values[i]) == 0);
+    }
+
+    //first match in list order, starting from the current item
+    List_first(list);
+    CHECK(List_search_parallel(list, valueEquals, &three) == &values[2]);
+    CHECK(List_curr(list) == &values[2]);
+    CHECK(List_next(list) == &values[3]);
+    CHECK(List_search_parallel(list, valueEquals, &three) == &values[5]);
+    CHECK(List_next(list) == &values[6]);
+    CHECK(List_search_parallel(list, valueEquals, &three) == &values[8]);
+    CHECK(List_search_parallel(list, valueEquals, &values[9]) == &values[9]);
+    CHECK(List_next(list) == NULL); //matched on the tail
+    CHECK(List_prev(list) == &values[9]);
+    CHECK(List_search_parallel(list, valueEquals, &eleven) == NULL);
+    CHECK(List_curr(list) == NULL);
+    CHECK(List_prev(list) == &values[9]);
+    List_first(list);
+    CHECK(List_prev(list) == NULL);
+    CHECK(List_search_parallel(list, valueEquals, &values[0]) == &values[0]);
+
+    //foreach and reduce cover the whole list
+    int sum = 0;
+    List_foreach_parallel(list, addValue, &sum);
+    CHECK(sum == 46);
+    CHECK((long)List_reduce_parallel(list, sumValues, sumResults, (void*)0, NULL) == 46);
+    CHECK(List_curr(list) == &values[0]);
+
+    //the same in node form, where the chunks are runs of nodes
+    CHECK(List_next(list) == &values[1]);
+    CHECK(List_remove(list) == &values[1]); //in the middle, so the list moves into nodes
+    CHECK(List_insert(list, &values[1]) == 0);
+    CHECK(list -> isLinked);
+    List_first(list);
+    CHECK(List_search_parallel(list, valueEquals, &three) == &values[2]);
+    CHECK(List_curr(list) == &values[2]);
+    CHECK(List_next(list) == &values[3]);
+    CHECK(List_search_parallel(list, valueEquals, &three) == &values[5]);
+    CHECK(List_next(list) == &values[6]);
+    CHECK(List_search_parallel(list, valueEquals, &three) == &values[8]);
+    CHECK(List_search_parallel(list, valueEquals, &values[9]) == &values[9]);
+    CHECK(List_next(list) == NULL);
+    CHECK(List_prev(list) == &values[9]);
+    CHECK(List_search_parallel(list, valueEquals, &eleven) == NULL);
+    CHECK(List_curr(list) == NULL);
+    CHECK(List_prev(list) == &values[9]);
+    List_first(list);
+    CHECK(List_search_parallel(list, valueEquals, &values[0]) == &values[0]);
+    sum = 0;
+    List_foreach_parallel(list, addValue, &sum);
+    CHECK(sum == 46);
+    CHECK((long)List_reduce_parallel(list, sumValues, sumResults, (void*)0, NULL) == 46);
+    CHECK(List_curr(list) == &values[0]);
+
+    complexTestFreeCounter = 0;
+    List_free(list, complexTestFreeFn);
+    CHECK(complexTestFreeCounter == 10);
+}
+
+// For the bulk iteration tests
+static bool isBelowLimit(void* pItem, void* pContext)
+{
+    return *(int*)pItem < *(int*)pContext;
+}
+
+static bool isOdd(void* pItem, void* pContext)
+{
+    return *(int*)pItem % 2 == 1;
+}
+
+static void* nextItem(void* pItem, void* pContext)
+{
+    return (int*)pItem + 1;
+}
+
+static void testBulkIteration()
+{
+    List * list = List_create();
+    int values[11] = {1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11};
+    int limit = 11;
+
+    CHECK(List_foreach(list, isBelowLimit, &limit) == NULL); //empty list
+    CHECK(List_filter_inplace(list, isOdd, NULL, complexTestFreeFn) == 0);
+    for (int i = 0; i < 9; i++)
+    {
+        CHECK(List_append(list, &values[i]) == 0);
+    }
+
+    //foreach visits everything, or stops on the first item it rejects
+    CHECK(List_foreach(list, isBelowLimit, &limit) == NULL);
+    limit = 4;
+    CHECK(List_foreach(list, isBelowLimit, &limit) == &values[3]);
+    CHECK(List_curr(list) == &values[8]);
+
+    //filtering out the current item makes the next kept item current
+    List_first(list);
+    CHECK(List_next(list) == &values[1]);
+    complexTestFreeCounter = 0;
+    CHECK(List_filter_inplace(list, isOdd, NULL, complexTestFreeFn) == 4);
+    CHECK(complexTestFreeCounter == 4);
+    CHECK(List_count(list) == 5);
+    CHECK(List_curr(list) == &values[2]);
+    CHECK(List_prev(list) == &values[0]);
+    CHECK(List_prev(list) == NULL);
+    CHECK(List_next(list) == &values[0]);
+    CHECK(List_next(list) == &values[2]);
+    CHECK(List_next(list) == &values[4]);
+    CHECK(List_next(list) == &values[6]);
+    CHECK(List_next(list) == &values[8]);
+    CHECK(List_next(list) == NULL);
+
+    //the freed nodes can be used again
+    CHECK(List_append(list, &values[9]) == 0);
+
+    //map replaces items in place
+    List_map(list, nextItem, NULL);
+    CHECK(List_first(list) == &values[1]);
+    CHECK(List_last(list) == &values[10]);
+    CHECK(List_filter_inplace(list, isOdd, NULL, NULL) == 5);
+    CHECK(List_count(list) == 1);
+    CHECK(List_curr(list) == &values[10]);
+
+    //filtering out everything empties the list
+    limit = 0;
+    CHECK(List_filter_inplace(list, isBelowLimit, &limit, NULL) == 1);
+    CHECK(List_count(list) == 0);
+    CHECK(List_curr(list) == NULL);
+    CHECK(List_first(list) == NULL);
+
+    //the same in node form, where filtering relinks the nodes that are kept
+    for (int i = 0; i < 9; i++)
+    {
+        CHECK(List_append(list, &values[i]) == 0);
+    }
+    List_first(list);
+    CHECK(List_next(list) == &values[1]);
+    CHECK(List_remove(list) == &values[1]); //in the middle, so the list moves into nodes
+    CHECK(List_insert(list, &values[1]) == 0);
+    CHECK(list -> isLinked);
+    limit = 11;
+    CHECK(List_foreach(list, isBelowLimit, &limit) == NULL);
+    complexTestFreeCounter = 0;
+    CHECK(List_filter_inplace(list, isOdd, NULL, complexTestFreeFn) == 4);
+    CHECK(complexTestFreeCounter == 4);
+    CHECK(List_count(list) == 5);
+    CHECK(List_curr(list) == &values[2]);
+    CHECK(List_prev(list) == &values[0]);
+    CHECK(List_prev(list) == NULL);
+    CHECK(List_next(list) == &values[0]);
+    CHECK(List_next(list) == &values[2]);
+    CHECK(List_next(list) == &values[4]);
+    CHECK(List_next(list) == &values[6]);
+    CHECK(List_next(list) == &values[8]);
+    CHECK(List_next(list) == NULL);
+    CHECK(List_last(list) == &values[8]);
+
+    //taking out the current tail leaves current beyond the new tail
+    limit = 9;
+    CHECK(List_filter_inplace(list, isBelowLimit, &limit, NULL) == 1);
+    CHECK(List_curr(list) == NULL);
+    CHECK(List_prev(list) == &values[6]);
+    CHECK(List_first(list) == &values[0]);
+    List_map(list, nextItem, NULL);
+    CHECK(List_first(list) == &values[1]);
+    CHECK(List_last(list) == &values[7]);
+
+    limit = 0;
+    CHECK(List_filter_inplace(list, isBelowLimit, &limit, NULL) == 4);
+    CHECK(List_count(list) == 0);
+    CHECK(List_curr(list) == NULL);
+    CHECK(List_first(list) == NULL);
+    CHECK(List_append(list, &values[0]) == 0);
+    CHECK(List_first(list) == &values[0] && List_last(list) == &values[0]);
+
+    List_free(list, complexTestFreeFn);
+}
+
+static void testSnapshot()
+{
+    List * list = List_create();
+    List * list2 = List_create();
+    int values[5] = {1, 2, 3, 4, 5};
+    for (int i = 0; i < 5; i++)
+    {
+        CHECK(List_append(i % 2 == 0 ? list : list2, &values[i]) == 0);
+    }
+    List_first(list);
+    List_next(list);
+    int listIndex = list -> headIndex;
+    int list2Index = list2 -> headIndex;
+
+    //items copied into the image by value, loaded without a callback
+    CHECK(List_snapshot_save("test_snapshot.bin", sizeof(int), NULL, NULL) == 0);
+    values[2] = 33; //only the saved copy should come back
+    List_free(list, complexTestFreeFn);
+
+    List * lists[LIST_MAX_NUM_HEADS];
+    CHECK(List_snapshot_load("test_snapshot.bin", lists, sizeof(int) + 1, NULL, NULL) == -1); //wrong item size
+    CHECK(List_snapshot_load("test_snapshot.bin", lists, sizeof(int), NULL, NULL) == 2);
+    list = lists[listIndex];
+    list2 = lists[list2Index];
+    CHECK(List_count(list) == 3);
+    CHECK(*(int*)List_curr(list) == 3); //current comes back too
+    CHECK(*(int*)List_next(list) == 5);
+    CHECK(List_next(list) == NULL);
+    CHECK(*(int*)List_first(list) == 1);
+    CHECK(*(int*)List_first(list2) == 2);
+    CHECK(*(int*)List_next(list2) == 4);
+    CHECK(List_next(list2) == NULL);
+    values[2] = 3;
+
+    //item pointers stored as they are, with a recycled head in the pool
+    List_free(list, complexTestFreeFn);
+    List_free(list2, complexTestFreeFn);
+    list = List_create();
+    listIndex = list -> headIndex;
+    for (int i = 0; i < 5; i += 2)
+    {
+        CHECK(List_append(list, &values[i]) == 0);
+    }
+    CHECK(List_snapshot_save("test_snapshot.bin", 0, NULL, NULL) == 0);
+    CHECK(List_snapshot_load("test_snapshot.bin", lists, 0, NULL, NULL) == 1);
+    CHECK(lists[1 - listIndex] == NULL);
+    list = lists[listIndex];
+    CHECK(List_curr(list) == &values[4]);
+    CHECK(List_first(list) == &values[0]);
+    CHECK(List_next(list) == &values[2]);
+    CHECK(List_next(list) == &values[4]);
+    List * list3 = List_create(); //the recycled head is still available
+    CHECK(list3 != NULL);
+    remove("test_snapshot.bin");
+
+    complexTestFreeCounter = 0;
+    List_free(list, complexTestFreeFn);
+    CHECK(complexTestFreeCounter == 3);
+    List_free(list3, complexTestFreeFn);
+}
+
+// Saves the pool and reads the image back into image, returns its size
+static size_t saveSnapshotImage(unsigned char* image, size_t capacity)
+{
+    CHECK(List_snapshot_save("test_snapshot.bin", 0, NULL, NULL) == 0);
+    FILE * pFile = fopen("test_snapshot.bin", "rb");
+    CHECK(pFile != NULL);
+    size_t imageSize = fread(image, 1, capacity, pFile);
+    fclose(pFile);
+    CHECK(imageSize < capacity);
+    return imageSize;
+}
+
+// Writes a copy of image with one 32 bit field changed, and tries to load it
+static int loadDamagedSnapshot(const unsigned char* image, size_t imageSize, size_t offset, int32_t value)
+{
+    unsigned char damaged[4096];
+    memcpy(damaged, image, imageSize);
+    memcpy(damaged + offset, &value, sizeof(value));
+    FILE * pFile = fopen("test_snapshot.bin", "wb");
+    CHECK(pFile != NULL);
+    CHECK(fwrite(damaged, 1, imageSize, pFile) == imageSize);
+    fclose(pFile);
+    List * lists[LIST_MAX_NUM_HEADS];
+    return List_snapshot_load("test_snapshot.bin", lists, 0, NULL, NULL);
+}
+
+static void testSnapshotDamaged()
+{
+    List * list = List_create();
+    List * list2 = List_create();
+    int values[5] = {1, 2, 3, 4, 5};
+    CHECK(List_append(list, &values[0]) == 0);
+    CHECK(List_append(list, &values[4]) == 0);
+    List_first(list);
+    CHECK(List_add(list, &values[2]) == 0); //in the middle, so the list is in nodes
+    CHECK(List_append(list2, &values[1]) == 0);
+    CHECK(List_append(list2, &values[3]) == 0);
+    unsigned char image[4096];
+    size_t imageSize = saveSnapshotImage(image, sizeof(image));
+
+    //the image header is 32 bytes, with the head count and free node count at 16 and 28. It is
+    //followed by a 32 byte record per head, which holds the item count at 4, the current position
+    //at 8, the head and tail node indices at 12 and 16, and the index of the current ring item at 28,
+    //and then by the free head stack
+    size_t listRecord = 32 + 32 * list -> headIndex;
+    size_t list2Record = 32 + 32 * list2 -> headIndex;
+    CHECK(loadDamagedSnapshot(image, imageSize, listRecord + 12, 1000000) == -1); //head past the pool
+    CHECK(loadDamagedSnapshot(image, imageSize, listRecord + 16, -2) == -1);
+    CHECK(loadDamagedSnapshot(image, imageSize, listRecord + 4, 2) == -1);  //count short of the links
+    CHECK(loadDamagedSnapshot(image, imageSize, listRecord + 4, 4) == -1);  //count past the tail
+    CHECK(loadDamagedSnapshot(image, imageSize, list2Record + 28, 3) == -1);
+
+    //the pool is left as it was
+    CHECK(List_count(list) == 3);
+    CHECK(List_curr(list) == &values[2]);
+    CHECK(List_first(list) == &values[0]);
+    CHECK(List_next(list) == &values[2]);
+    CHECK(List_next(list) == &values[4]);
+    CHECK(List_last(list2) == &values[3]);
+    CHECK(loadDamagedSnapshot(image, imageSize, listRecord + 4, 3) == 2); //undamaged
+
+    //an empty list in nodes only comes back with no current position
+    List_free(list2, complexTestFreeFn);
+    List_first(list);
+    for (int i = 0; i < 3; i++)
+    {
+        CHECK(List_remove(list) != NULL);
+    }
+    imageSize = saveSnapshotImage(image, sizeof(image));
+    listRecord = 32 + 32 * list -> headIndex;
+    CHECK(loadDamagedSnapshot(image, imageSize, listRecord + 8, 4) == -1);
+    CHECK(loadDamagedSnapshot(image, imageSize, listRecord + 8, 0) == -1);
+    CHECK(loadDamagedSnapshot(image, imageSize, listRecord + 8, -1) == 1);
+    CHECK(List_next(list) == NULL);
+    CHECK(List_prev(list) == NULL);
+
+    //every head on the free stack once, and every node either in a list or free
+    List_free(list, complexTestFreeFn);
+    imageSize = saveSnapshotImage(image, sizeof(image));
+    int32_t headCount, freeNodeCount, firstFreeHead;
+    memcpy(&headCount, image + 16, sizeof(int32_t));
+    memcpy(&freeNodeCount, image + 28, sizeof(int32_t));
+    memcpy(&firstFreeHead, image + 32 + 32 * headCount, sizeof(int32_t));
+    CHECK(headCount == 2 && freeNodeCount >= 3);
+    CHECK(loadDamagedSnapshot(image, imageSize, 32 + 32 * headCount + 4, firstFreeHead) == -1);
+    CHECK(loadDamagedSnapshot(image, imageSize, 28, freeNodeCount - 1) == -1);
+    CHECK(loadDamagedSnapshot(image, imageSize, 28, freeNodeCount) == 0);
+    list = List_create();
+    list2 = List_create();
+    CHECK(list != NULL && list2 != NULL && list != list2);
+    remove("test_snapshot.bin");
+
+    List_free(list, complexTestFreeFn);
+    List_free(list2, complexTestFreeFn);
+}
+
+// For the intrusive tests: items embed their own hook
+typedef struct Job_s Job;
+struct Job_s
+{
+    int id;
+    ListHook hook;
+};
+
+static bool jobHasId(ListHook* pHook, void* pArg)
+{
+    return LIST_ENTRY(pHook, Job, hook) -> id == *(int*)pArg;
+}
+
+static void testIntrusive()
+{
+    //far more items than there are nodes in the pool
+    Job jobs[50];
+    ListIntrusive list;
+    ListIntrusive list2;
+    ListIntrusive_init(&list);
+    ListIntrusive_init(&list2);
+    CHECK(ListIntrusive_first(&list) == NULL);
+    CHECK(ListIntrusive_next(&list) == NULL);
+    CHECK(ListIntrusive_prev(&list) == NULL);
+    CHECK(ListIntrusive_trim(&list) == NULL);
+
+    for (int i = 0; i < 50; i++)
+    {
+        jobs[i].id = i;
+    }
+    for (int i = 20; i < 40; i++)
+    {
+        ListIntrusive_append(&list, &jobs[i].hook);
+    }
+    for (int i = 19; i >= 10; i--)
+    {
+        ListIntrusive_prepend(&list, &jobs[i].hook);
+    }
+    CHECK(ListIntrusive_count(&list) == 30);
+    CHECK(ListIntrusive_first(&list) == &jobs[10].hook);
+    CHECK(ListIntrusive_last(&list) == &jobs[39].hook);
+
+    //add goes after current, insert before it
+    int id = 25;
+    CHECK(ListIntrusive_search(&list, jobHasId, &id) == NULL); //current was on the tail
+    CHECK(ListIntrusive_curr(&list) == NULL);
+    CHECK(ListIntrusive_prev(&list) == &jobs[39].hook);
+    ListIntrusive_first(&list);
+    CHECK(LIST_ENTRY(ListIntrusive_search(&list, jobHasId, &id), Job, hook) == &jobs[25]);
+    ListIntrusive_add(&list, &jobs[40].hook);
+    ListIntrusive_insert(&list, &jobs[41].hook);
+    CHECK(ListIntrusive_prev(&list) == &jobs[25].hook);
+    CHECK(ListIntrusive_next(&list) == &jobs[41].hook);
+    CHECK(ListIntrusive_next(&list) == &jobs[40].hook);
+    CHECK(ListIntrusive_next(&list) == &jobs[26].hook);
+
+    //remove makes the next item current, trim the new tail
+    CHECK(ListIntrusive_prev(&list) == &jobs[40].hook);
+    CHECK(ListIntrusive_remove(&list) == &jobs[40].hook);
+    CHECK(ListIntrusive_remove(&list) == &jobs[26].hook);
+    CHECK(ListIntrusive_curr(&list) == &jobs[27].hook);
+    CHECK(ListIntrusive_trim(&list) == &jobs[39].hook);
+    CHECK(ListIntrusive_curr(&list) == &jobs[38].hook);
+    CHECK(ListIntrusive_count(&list) == 29);
+
+    //before the start and beyond the end
+    ListIntrusive_first(&list);
+    CHECK(ListIntrusive_prev(&list) == NULL);
+    CHECK(ListIntrusive_remove(&list) == NULL);
+    ListIntrusive_add(&list, &jobs[0].hook);
+    CHECK(ListIntrusive_first(&list) == &jobs[0].hook);
+    ListIntrusive_last(&list);
+    CHECK(ListIntrusive_next(&list) == NULL);
+    ListIntrusive_insert(&list, &jobs[1].hook);
+    CHECK(ListIntrusive_last(&list) == &jobs[1].hook);
+
+    //concat empties the second list
+    for (int i = 42; i < 50; i++)
+    {
+        ListIntrusive_append(&list2, &jobs[i].hook);
+    }
+    ListIntrusive_first(&list);
+    ListIntrusive_concat(&list, &list2);
+    CHECK(ListIntrusive_count(&list) == 39);
+    CHECK(ListIntrusive_count(&list2) == 0);
+    CHECK(ListIntrusive_first(&list2) == NULL);
+    CHECK(ListIntrusive_curr(&list) == &jobs[0].hook);
+    CHECK(ListIntrusive_last(&list) == &jobs[49].hook);
+    int count = 0;
+    while (ListIntrusive_trim(&list) != NULL)
+    {
+        count++;
+    }
+    CHECK(count == 39);
+    CHECK(ListIntrusive_curr(&list) == NULL);
+}
+
+static void testRing()
+{
+    List * list = List_create();
+    List * list2 = List_create();
+    int values[10] = {0, 1, 2, 3, 4, 5, 6, 7, 8, 9};
+
+    //deque-style use stays in ring form, wrapping around the buffer
+    CHECK(!list -> isLinked);
+    CHECK(List_append(list, &values[5]) == 0);
+    CHECK(List_prepend(list, &values[4]) == 0);
+    CHECK(List_append(list, &values[6]) == 0);
+    CHECK(List_prepend(list, &values[3]) == 0);
+    CHECK(List_count(list) == 4);
+    CHECK(List_curr(list) == &values[3]);
+    CHECK(List_first(list) == &values[3]);
+    CHECK(List_next(list) == &values[4]);
+    CHECK(List_next(list) == &values[5]);
+    CHECK(List_last(list) == &values[6]);
+    CHECK(List_next(list) == NULL);
+    CHECK(List_prev(list) == &values[6]);
+    List_first(list);
+    CHECK(List_search(list, itemEquals, &values[5]) == &values[5]);
+    CHECK(List_trim(list) == &values[6]);
+    CHECK(List_curr(list) == &values[5]);
+    List_first(list);
+    CHECK(List_remove(list) == &values[3]);
+    CHECK(List_curr(list) == &values[4]);
+    CHECK(!list -> isLinked);
+
+    //ring items count against the pool like nodes do
+    for (int i = 0; i < 8; i++)
+    {
+        CHECK(List_append(list2, &values[i]) == 0);
+    }
+    CHECK(List_append(list2, &values[8]) == -1);
+    CHECK(List_count(list2) == 8);
+
+    //concatenating two rings keeps the ring form
+    List_last(list);
+    List_concat(list, list2);
+    CHECK(List_count(list) == 10);
+    CHECK(List_curr(list) == &values[5]);
+    CHECK(List_next(list) == &values[0]);
+    CHECK(List_last(list) == &values[7]);
+    CHECK(!list -> isLinked);
+
+    //filtering in ring form compacts the buffer
+    List_first(list);
+    CHECK(List_filter_inplace(list, isOdd, NULL, NULL) == 5);
+    CHECK(List_count(list) == 5);
+    CHECK(List_first(list) == &values[5]);
+    CHECK(List_next(list) == &values[1]);
+    CHECK(List_last(list) == &values[7]);
+    CHECK(!list -> isLinked);
+
+    //adding in the middle moves the items into nodes for good
+    List_first(list);
+    CHECK(List_add(list, &values[2]) == 0);
+    CHECK(list -> isLinked);
+    CHECK(List_curr(list) == &values[2]);
+    CHECK(List_prev(list) == &values[5]);
+    CHECK(List_next(list) == &values[2]);
+    CHECK(List_next(list) == &values[1]);
+    CHECK(List_count(list) == 6);
+
+    //a ring concatenated onto a linked list is moved into nodes
+    list2 = List_create();
+    CHECK(List_append(list2, &values[8]) == 0);
+    CHECK(List_append(list2, &values[9]) == 0);
+    List_concat(list, list2);
+    CHECK(List_count(list) == 8);
+    CHECK(List_last(list) == &values[9]);
+    CHECK(List_prev(list) == &values[8]);
+    CHECK(List_prev(list) == &values[7]);
+
+    List_free(list, complexTestFreeFn);
+}
+
+static void testSearchMany()
+{
+    List * list = List_create();
+    int values[6] = {1, 2, 3, 4, 5, 3};
+    int missing = 3;
+    void * results[5];
+    for (int i = 0; i < 6; i++)
+    {
+        CHECK(List_append(list, &values[i]) == 0);
+    }
+
+    //by address: duplicate keys all match, keys not in the list stay NULL
+    void * keys[5] = {&values[4], &missing, &values[0], &values[4], &values[2]};
+    List_first(list);
+    CHECK(List_search_many(list, NULL, keys, 5, results) == 4);
+    CHECK(results[0] == &values[4] && results[3] == &values[4]);
+    CHECK(results[1] == NULL);
+    CHECK(results[2] == &values[0]);
+    CHECK(results[4] == &values[2]);
+    CHECK(List_curr(list) == &values[0]);
+
+    //with a comparator, each key gets its first match from the current item on
+    void * valueKeys[3] = {&missing, &values[0], &values[1]};
+    CHECK(List_next(list) == &values[1]);
+    CHECK(List_search_many(list, valueEquals, valueKeys, 3, results) == 2);
+    CHECK(results[0] == &values[2]);
+    CHECK(results[1] == NULL);
+    CHECK(results[2] == &values[1]);
+    CHECK(List_curr(list) == &values[1]);
+
+    //the same in node form, and past the end nothing matches
+    List_add(list, &missing);
+    CHECK(list -> isLinked);
+    CHECK(List_search_many(list, valueEquals, valueKeys, 3, results) == 1);
+    CHECK(results[0] == &missing);
+    CHECK(List_search_many(list, NULL, keys, 5, results) == 4);
+    CHECK(results[1] == &missing && results[2] == NULL);
+    List_last(list);
+    List_next(list);
+    CHECK(List_search_many(list, NULL, keys, 5, results) == 0);
+    CHECK(results[2] == NULL);
+
+    List_free(list, complexTestFreeFn);
+}
+
+// For the epoch test: a reader thread that holds a read-side section until told to walk the list
+typedef struct EpochReader_s
+{
+    List * pList;
+    int entered;
+    int release;
+    int sum;
+} EpochReader;
+
+static bool sumItems(void* pItem, void* pContext)
+{
+    *(int*)pContext += *(int*)pItem;
+    return true;
+}
+
+static void* epochReaderMain(void* pArg)
+{
+    EpochReader * pReader = pArg;
+    CHECK(List_reader_enter() == 0);
+    __atomic_store_n(&pReader -> entered, 1, __ATOMIC_RELEASE);
+    while (!__atomic_load_n(&pReader -> release, __ATOMIC_ACQUIRE))
+    {
+        sched_yield();
+    }
+    List_foreach(pReader -> pList, sumItems, &pReader -> sum);
+    List_reader_exit();
+    return NULL;
+}
+
+static void testEpoch()
+{
+    List * list = List_create();
+    int values[11] = {1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11};
+    for (int i = 0; i < 10; i++)
+    {
+        CHECK(List_append(list, &values[i]) == 0);
+    }
+
+    //turning epoch mode on moves lists into nodes, and new lists start out as nodes
+    List_epoch_enable();
+    CHECK(list -> isLinked);
+    List * list2 = List_create();
+    CHECK(list2 -> isLinked);
+    List_free(list2, complexTestFreeFn);
+
+    //a node taken out while a reader is inside its section is not handed out again
+    EpochReader reader = {list, 0, 0, 0};
+    pthread_t thread;
+    CHECK(pthread_create(&thread, NULL, epochReaderMain, &reader) == 0);
+    while (!__atomic_load_n(&reader.entered, __ATOMIC_ACQUIRE))
+    {
+        sched_yield();
+    }
+    List_first(list);
+    CHECK(List_remove(list) == &values[0]);
+    CHECK(List_count(list) == 9);
+    CHECK(List_append(list, &values[10]) == -1);
+
+    //the reader walks the list as it is now, then leaves, and the node can be used again
+    __atomic_store_n(&reader.release, 1, __ATOMIC_RELEASE);
+    CHECK(pthread_join(thread, NULL) == 0);
+    CHECK(reader.sum == 54);
+    CHECK(List_append(list, &values[10]) == 0);
+    CHECK(List_last(list) == &values[10]);
+
+    //after synchronizing, every node taken out is back in the pool
+    CHECK(List_trim(list) == &values[10]);
+    CHECK(List_trim(list) == &values[9]);
+    List_epoch_synchronize();
+    CHECK(List_append(list, &values[9]) == 0);
+    CHECK(List_append(list, &values[10]) == 0);
+    CHECK(List_append(list, &values[0]) == -1);
+
+    //an image can be saved but not loaded while the mode is on, and nodes kept for readers are free in it
+    CHECK(List_trim(list) == &values[10]);
+    CHECK(List_trim(list) == &values[9]);
+    CHECK(List_snapshot_save("test_snapshot.bin", 0, NULL, NULL) == 0);
+    List * lists[LIST_MAX_NUM_HEADS];
+    CHECK(List_snapshot_load("test_snapshot.bin", lists, 0, NULL, NULL) == -1);
+    List_epoch_synchronize();
+    CHECK(List_count(list) == 8);
+
+    List_epoch_disable();
+    CHECK(List_snapshot_load("test_snapshot.bin", lists, 0, NULL, NULL) == 1);
+    remove("test_snapshot.bin");
+    list = lists[list -> headIndex];
+    CHECK(List_count(list) == 8);
+    CHECK(List_append(list, &values[9]) == 0);
+    CHECK(List_append(list, &values[10]) == 0);
+    CHECK(List_append(list, &values[0]) == -1);
+    List_free(list, complexTestFreeFn);
+}
+
 static void testComplex()
 {
     //creating a new list and checking initial stats
@@ -245,6 +926,14 @@ static void testComplex()
 
 int main(int argCount, char *args[]) 
 {
+    testParallel();
+    testBulkIteration();
+    testSnapshot();
+    testSnapshotDamaged();
+    testIntrusive();
+    testRing();
+    testSearchMany();
+    testEpoch();
     testComplex();
 
     // We got here?!? PASSED!
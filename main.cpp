@@ -0,0 +1,171 @@
+/**
+ * Sample test code for the C++ front-end, tests that it works as it is supposed to
+ */
+
+#include "list.hpp"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <numeric>
+#include <string>
+
+// Macro for custom testing; does exit(1) on failure.
+#define CHECK(condition) do{ \
+    if (!(condition)) { \
+        printf("ERROR: %s (@%d): failed condition \"%s\"\n", __func__, __LINE__, #condition); \
+        exit(1);\
+    }\
+} while(0)
+
+struct Point
+{
+    int x;
+    int y;
+};
+
+static void testTypedList()
+{
+    using PointList = listfn::List<Point, 4>;
+    static_assert(PointList::capacity() == 4, "capacity is known at compile time");
+
+    PointList points;
+    CHECK(points.empty());
+    CHECK(points.push_back({2, 20}));
+    CHECK(points.push_back({3, 30}));
+    CHECK(points.push_front({1, 10}));
+    CHECK(points.emplace(std::next(points.cbegin(), 2), Point{5, 50}) != points.end());
+    CHECK(points.size() == 4);
+    CHECK(PointList::available() == 0);
+
+    //running out of nodes fails without changing the list
+    CHECK(!points.push_back({9, 90}));
+    CHECK(points.emplace(points.cbegin(), Point{9, 90}) == points.end());
+    CHECK(points.size() == 4);
+
+    //comparators are plain lambdas
+    auto sameX = [](const Point & point, int x) { return point.x == x; };
+    CHECK(points.search(points.cbegin(), sameX, 5) -> y == 50);
+    CHECK(points.search(std::next(points.cbegin(), 3), sameX, 5) == points.end());
+
+    //the std algorithms work on the iterators
+    int expected[4] = {1, 2, 5, 3};
+    CHECK(std::equal(points.begin(), points.end(), expected, [](const Point & point, int x) { return point.x == x; }));
+    CHECK(std::find_if(points.begin(), points.end(), [](const Point & point) { return point.y > 40; }) -> x == 5);
+    std::reverse(points.begin(), points.end());
+    CHECK(points.front().x == 3 && points.back().x == 1);
+    CHECK((--points.end()) -> x == 1);
+
+    //erasing returns the nodes to the pool
+    CHECK(points.erase(points.search(points.cbegin(), sameX, 5)) -> x == 2);
+    CHECK(points.pop_back());
+    CHECK(points.pop_front());
+    CHECK(points.size() == 1 && points.front().x == 2);
+    CHECK(PointList::available() == 3);
+
+    //moving hands over the nodes, concat splices them
+    PointList moved = std::move(points);
+    CHECK(points.empty() && moved.size() == 1);
+    PointList other;
+    CHECK(other.push_back({7, 70}));
+    CHECK(other.push_back({8, 80}));
+    moved.concat(other);
+    CHECK(other.empty() && moved.size() == 3);
+    CHECK(std::accumulate(moved.begin(), moved.end(), 0, [](int sum, const Point & point) { return sum + point.x; }) == 17);
+    moved.clear();
+    CHECK(moved.empty() && PointList::available() == 4);
+}
+
+static void testNonTrivialItems()
+{
+    listfn::List<std::string, 3> words;
+    CHECK(words.emplace_back(20, 'a'));
+    CHECK(words.emplace_back("list"));
+    CHECK(words.front().size() == 20);
+    CHECK(words.pop_front());
+    CHECK(words.front() == "list");
+    //the destructor destroys what is left
+}
+
+// Throws from its constructor when asked to
+struct Boom
+{
+    explicit Boom(bool shouldThrow)
+    {
+        if (shouldThrow)
+        {
+            throw 1;
+        }
+    }
+};
+
+static void testThrowingConstructor()
+{
+    using BoomList = listfn::List<Boom, 4>;
+    BoomList booms;
+    CHECK(booms.emplace_back(false));
+    bool thrown = false;
+    try
+    {
+        booms.emplace_front(true);
+    }
+    catch (int)
+    {
+        thrown = true;
+    }
+
+    //the node taken for the item goes back to the pool, and the list is unchanged
+    CHECK(thrown);
+    CHECK(booms.size() == 1);
+    CHECK(BoomList::available() == 3);
+    for (int i = 0; i < 3; i++)
+    {
+        CHECK(booms.emplace_back(false));
+    }
+    CHECK(BoomList::available() == 0);
+}
+
+// For searching the C list
+static bool itemEquals(void* pItem, void* pArg)
+{
+    return pItem == pArg;
+}
+
+static void testCInterop()
+{
+    listfn::List<int, 8> numbers;
+    for (int i = 1; i <= 3; i++)
+    {
+        CHECK(numbers.push_back(i * 10));
+    }
+
+    //the typed items can be handed to the C API as pointers
+    List * pList = List_create();
+    CHECK(pList != NULL);
+    CHECK(numbers.append_to(pList));
+    CHECK(List_count(pList) == 3);
+    List_first(pList);
+    CHECK(List_search(pList, itemEquals, &*std::next(numbers.begin())) == &*std::next(numbers.begin()));
+
+    //and a C list can be walked with the std algorithms
+    listfn::CListView<int> view(pList);
+    CHECK(view.size() == 3);
+    CHECK(std::accumulate(view.begin(), view.end(), 0) == 60);
+    CHECK(*std::prev(view.end()) == 30);
+    CHECK(List_curr(pList) == &*std::next(numbers.begin())); //the view leaves current alone
+
+    List_free(pList, [](void*) {});
+}
+
+int main(int argCount, char *args[])
+{
+    testTypedList();
+    testNonTrivialItems();
+    testThrowingConstructor();
+    testCInterop();
+
+    // We got here?!? PASSED!
+    printf("********************************\n");
+    printf("           PASSED\n");
+    printf("********************************\n");
+    return 0;
+}
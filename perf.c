@@ -0,0 +1,397 @@
+/**
+ * Hardware counter profile of the list functions, run by "make perf".
+ *
+ * Each chosen operation runs on a list of nodes of each chosen size and fragmentation level, wrapped
+ * in Linux perf_event_open counters (user space only). The table gives the counter deltas per call.
+ * If a counter cannot be opened (no PMU in a VM, perf_event_paranoid too high, ...), its column
+ * reads "-", and if none can, only the wall-clock time is reported.
+ *
+ * Usage: build/perf/listperf [-n size]... [-f fragmentation]... [operation]...
+ *   size           items in the list (default 1000, 100000 and 1000000)
+ *   fragmentation  share of the list's nodes placed at random spots in the pool, from 0 (nodes in
+ *                  pool order, as a freshly built list gets them) to 1 (default 0, 0.5 and 1)
+ *   operation      search, foreach, walk, trim or free (default all of them)
+ */
+
+#define _GNU_SOURCE
+#include "list.h"
+#include <errno.h>
+#include <linux/perf_event.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+
+#define MAX_CHOICES 16
+#define WALK_CALLS 5            //calls per measurement of the operations that walk the whole list
+#define TRIM_CALLS 100000       //calls per measurement of List_trim
+
+#define CACHE_EVENT(cache, op, result) \
+    ((PERF_COUNT_HW_CACHE_##cache) | (PERF_COUNT_HW_CACHE_OP_##op << 8) | (PERF_COUNT_HW_CACHE_RESULT_##result << 16))
+
+typedef struct Counter_s Counter;
+struct Counter_s
+{
+    const char* pName;
+    uint32_t type;
+    uint64_t config;
+    int fd;                 //-1 if the counter could not be opened
+    double start;           //scaled value when the measurement started
+    double total;           //scaled delta summed over the measurement
+};
+
+static Counter counters[] = {
+    {"cycles", PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES, -1, 0, 0},
+    {"instr", PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS, -1, 0, 0},
+    {"L1d-miss", PERF_TYPE_HW_CACHE, CACHE_EVENT(L1D, READ, MISS), -1, 0, 0},
+    {"LLC-miss", PERF_TYPE_HW_CACHE, CACHE_EVENT(LL, READ, MISS), -1, 0, 0},
+    {"br-miss", PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES, -1, 0, 0},
+    {"dTLB-miss", PERF_TYPE_HW_CACHE, CACHE_EVENT(DTLB, READ, MISS), -1, 0, 0},
+};
+#define COUNTER_COUNT ((int) (sizeof(counters) / sizeof(counters[0])))
+
+static double elapsedNs;        //wall-clock time summed over the measurement
+static struct timespec startTime;
+
+//COUNTERS:
+//opens every counter it can, returns the number opened
+static int openCounters()
+{
+    int openCount = 0;
+    for (int i = 0; i < COUNTER_COUNT; i++)
+    {
+        struct perf_event_attr attr;
+        memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        attr.type = counters[i].type;
+        attr.config = counters[i].config;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        //the counters may have to share the PMU, so they are scaled by the time they actually ran
+        attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+        counters[i].fd = (int) syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+        if (counters[i].fd < 0)
+        {
+            fprintf(stderr, "perf: %s unavailable (%s)\n", counters[i].pName, strerror(errno));
+            continue;
+        }
+        openCount++;
+    }
+    if (openCount == 0)
+    {
+        fprintf(stderr, "perf: no hardware counters, reporting wall-clock time only\n");
+    }
+    return openCount;
+}
+
+//returns the value of a counter, scaled up if it only ran part of the time
+static double readCounter(Counter* pCounter)
+{
+    uint64_t values[3]; //value, time enabled, time running
+    if (read(pCounter -> fd, values, sizeof(values)) != sizeof(values) || values[2] == 0)
+    {
+        return 0;
+    }
+    return (double) values[0] * values[1] / values[2];
+}
+
+static void resetCounters()
+{
+    elapsedNs = 0;
+    for (int i = 0; i < COUNTER_COUNT; i++)
+    {
+        counters[i].total = 0;
+    }
+    return;
+}
+
+static void startCounters()
+{
+    for (int i = 0; i < COUNTER_COUNT; i++)
+    {
+        if (counters[i].fd >= 0)
+        {
+            counters[i].start = readCounter(&counters[i]);
+        }
+    }
+    clock_gettime(CLOCK_MONOTONIC, &startTime);
+    return;
+}
+
+static void stopCounters()
+{
+    struct timespec stopTime;
+    clock_gettime(CLOCK_MONOTONIC, &stopTime);
+    elapsedNs += (stopTime.tv_sec - startTime.tv_sec) * 1e9 + (stopTime.tv_nsec - startTime.tv_nsec);
+    for (int i = 0; i < COUNTER_COUNT; i++)
+    {
+        if (counters[i].fd >= 0)
+        {
+            counters[i].total += readCounter(&counters[i]) - counters[i].start;
+        }
+    }
+    return;
+}
+
+static void printHeader()
+{
+    printf("%-8s %8s %5s %12s", "op", "size", "frag", "ns/call");
+    for (int i = 0; i < COUNTER_COUNT; i++)
+    {
+        printf(" %12s", counters[i].pName);
+    }
+    printf("\n");
+    return;
+}
+
+static void printRow(const char* pOperation, int size, double fragmentation, long calls)
+{
+    printf("%-8s %8d %5.2f %12.1f", pOperation, size, fragmentation, elapsedNs / calls);
+    for (int i = 0; i < COUNTER_COUNT; i++)
+    {
+        if (counters[i].fd >= 0)
+        {
+            printf(" %12.1f", counters[i].total / calls);
+        }
+        else
+        {
+            printf(" %12s", "-");
+        }
+    }
+    printf("\n");
+    return;
+}
+
+//LISTS:
+static int item; //every list holds this same item
+
+static bool neverEquals(void* pItem, void* pArg)
+{
+    return pItem == pArg;
+}
+
+static bool visitItem(void* pItem, void* pContext)
+{
+    (*(long*)pContext)++;
+    return true;
+}
+
+static void freeItem(void* pItem)
+{
+    return;
+}
+
+//takes pNode out of pList by putting the current pointer straight on it, so that nodes can be
+//given back to the pool in any order without walking to them
+static void removeNode(List* pList, Node* pNode)
+{
+    pList -> current = pNode;
+    pList -> currentPosition = pNode == pList -> head ? 1 : pNode == pList -> tail ? 3 : 2;
+    List_remove(pList);
+    return;
+}
+
+//makes an empty list already moved into nodes (lists start out in ring form, see List_s)
+static List* createLinkedList()
+{
+    List* pList = List_create();
+    List_append(pList, &item);
+    List_append(pList, &item);
+    List_first(pList);
+    List_add(pList, &item);
+    while (List_count(pList) > 0)
+    {
+        List_trim(pList);
+    }
+    return pList;
+}
+
+//builds a list of size items whose nodes sit in the pool in an order where a share fragmentation
+//of them has been swapped with a random other one: the nodes are first taken by a scratch list,
+//then given back in the wanted order, so that the list being built pops them off the free stack in turn
+static List* createFragmentedList(int size, double fragmentation, Node** nodeByIndex, int* order)
+{
+    List* pList = createLinkedList();
+    List* pScratch = createLinkedList();
+    for (int i = 0; i < size; i++)
+    {
+        List_append(pScratch, &item);
+    }
+
+    int nodeCount = 0;
+    memset(nodeByIndex, 0, LIST_MAX_NUM_NODES * sizeof(Node*));
+    for (Node* pNode = pScratch -> head; pNode != NULL; pNode = pNode -> next)
+    {
+        nodeByIndex[pNode -> nodeIndex] = pNode;
+    }
+    for (int i = 0; i < LIST_MAX_NUM_NODES; i++) //pool order
+    {
+        if (nodeByIndex[i] != NULL)
+        {
+            order[nodeCount++] = i;
+        }
+    }
+    for (int i = 0; i < nodeCount; i++)
+    {
+        if ((double) rand() / RAND_MAX < fragmentation)
+        {
+            int j = i + rand() % (nodeCount - i);
+            int swap = order[i];
+            order[i] = order[j];
+            order[j] = swap;
+        }
+    }
+
+    for (int i = nodeCount - 1; i >= 0; i--) //last one first, since the free stack hands them out in reverse
+    {
+        removeNode(pScratch, nodeByIndex[order[i]]);
+    }
+    List_free(pScratch, freeItem);
+    for (int i = 0; i < size; i++)
+    {
+        List_append(pList, &item);
+    }
+    return pList;
+}
+
+//runs one operation on one list, returns the number of calls measured
+static long runOperation(const char* pOperation, int size, double fragmentation, Node** nodeByIndex, int* order)
+{
+    List* pList = createFragmentedList(size, fragmentation, nodeByIndex, order);
+    long visited = 0;
+    long calls = 0;
+
+    if (strcmp(pOperation, "search") == 0) //a miss walks the whole list
+    {
+        for (calls = 0; calls < WALK_CALLS; calls++)
+        {
+            List_first(pList);
+            startCounters();
+            List_search(pList, neverEquals, NULL);
+            stopCounters();
+        }
+    }
+    else if (strcmp(pOperation, "foreach") == 0)
+    {
+        startCounters();
+        for (calls = 0; calls < WALK_CALLS; calls++)
+        {
+            List_foreach(pList, visitItem, &visited);
+        }
+        stopCounters();
+    }
+    else if (strcmp(pOperation, "walk") == 0) //List_first, then List_next until the end
+    {
+        startCounters();
+        for (calls = 0; calls < WALK_CALLS; calls++)
+        {
+            for (void* pItem = List_first(pList); pItem != NULL; pItem = List_next(pList))
+            {
+                visited++;
+            }
+        }
+        stopCounters();
+    }
+    else if (strcmp(pOperation, "trim") == 0) //take the tail off and put it back
+    {
+        startCounters();
+        for (calls = 0; calls < TRIM_CALLS; calls++)
+        {
+            List_trim(pList);
+            List_append(pList, &item);
+        }
+        stopCounters();
+    }
+    else if (strcmp(pOperation, "free") == 0) //the list is built again between calls
+    {
+        for (calls = 0; calls < WALK_CALLS; calls++)
+        {
+            startCounters();
+            List_free(pList, freeItem);
+            stopCounters();
+            pList = createFragmentedList(size, fragmentation, nodeByIndex, order);
+        }
+    }
+    else
+    {
+        fprintf(stderr, "perf: unknown operation %s\n", pOperation);
+        calls = 0;
+    }
+
+    List_free(pList, freeItem);
+    return calls;
+}
+
+int main(int argCount, char* args[])
+{
+    int sizes[MAX_CHOICES] = {1000, 100000, 1000000};
+    double fragmentations[MAX_CHOICES] = {0, 0.5, 1};
+    const char* operations[MAX_CHOICES] = {"search", "foreach", "walk", "trim", "free"};
+    int sizeCount = 0;
+    int fragmentationCount = 0;
+    int operationCount = 0;
+
+    for (int i = 1; i < argCount; i++)
+    {
+        if (strcmp(args[i], "-n") == 0 && i + 1 < argCount && sizeCount < MAX_CHOICES)
+        {
+            sizes[sizeCount++] = atoi(args[++i]);
+        }
+        else if (strcmp(args[i], "-f") == 0 && i + 1 < argCount && fragmentationCount < MAX_CHOICES)
+        {
+            fragmentations[fragmentationCount++] = atof(args[++i]);
+        }
+        else if (args[i][0] != '-' && operationCount < MAX_CHOICES)
+        {
+            operations[operationCount++] = args[i];
+        }
+        else
+        {
+            fprintf(stderr, "usage: %s [-n size]... [-f fragmentation]... [operation]...\n", args[0]);
+            return 1;
+        }
+    }
+    sizeCount = sizeCount == 0 ? 3 : sizeCount;
+    fragmentationCount = fragmentationCount == 0 ? 3 : fragmentationCount;
+    operationCount = operationCount == 0 ? 5 : operationCount;
+
+    Node** nodeByIndex = malloc(LIST_MAX_NUM_NODES * sizeof(Node*));
+    int* order = malloc(LIST_MAX_NUM_NODES * sizeof(int));
+    if (nodeByIndex == NULL || order == NULL)
+    {
+        fprintf(stderr, "perf: out of memory\n");
+        return 1;
+    }
+    srand(1);
+    openCounters();
+    printHeader();
+
+    for (int s = 0; s < sizeCount; s++)
+    {
+        //the list, its scratch list and the few nodes a list takes on the way into node form
+        if (sizes[s] < 1 || sizes[s] > LIST_MAX_NUM_NODES - 8)
+        {
+            fprintf(stderr, "perf: size %d does not fit the pool of %d nodes\n", sizes[s], LIST_MAX_NUM_NODES);
+            continue;
+        }
+        for (int f = 0; f < fragmentationCount; f++)
+        {
+            for (int o = 0; o < operationCount; o++)
+            {
+                resetCounters();
+                long calls = runOperation(operations[o], sizes[s], fragmentations[f], nodeByIndex, order);
+                if (calls > 0)
+                {
+                    printRow(operations[o], sizes[s], fragmentations[f], calls);
+                }
+            }
+        }
+    }
+
+    free(nodeByIndex);
+    free(order);
+    return 0;
+}
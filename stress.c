@@ -0,0 +1,537 @@
+/**
+ * Randomized workload driver for the list functions, run by "make stress".
+ *
+ * Writer threads replay a weighted mix of operations on their own lists, all drawing nodes from the
+ * shared pool (so every call is made under one lock), and check every result, count and current
+ * item against a simple reference model: an array of items and an index for the current one.
+ * Optional reader threads walk random lists with List_foreach in epoch mode at the same time.
+ * Each configuration reports throughput and latency percentiles (lock wait included), and the run
+ * stops with the seed and operation on the first result that does not match the model.
+ * The same seed and options replay the same operations on every thread.
+ *
+ * Usage: build/stress-<pool size>/stress [options]
+ *   -s seed      seed of the random operations (default 1)
+ *   -t threads   writer threads (default 4)
+ *   -r readers   reader threads walking lists in epoch mode (default 0)
+ *   -l lists     lists, shared out among the writers (repeatable, default 16)
+ *   -n length    items each list starts with (repeatable, default 256)
+ *   -o ops       operations per writer thread (default 100000)
+ *   -m mix       weighted operations, e.g. search=70,append=20,remove=10 (default below)
+ *                operations: search, append, prepend, add, insert, remove, trim, first, last, next, prev
+ */
+
+#define _GNU_SOURCE
+#include "list.h"
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define MAX_CHOICES 16
+#define DEFAULT_MIX "search=40,append=15,prepend=5,add=10,insert=5,remove=15,trim=5,first=1,last=1,next=2,prev=1"
+
+typedef enum
+{
+    OP_SEARCH, OP_APPEND, OP_PREPEND, OP_ADD, OP_INSERT, OP_REMOVE, OP_TRIM,
+    OP_FIRST, OP_LAST, OP_NEXT, OP_PREV, OP_COUNT
+} Operation;
+
+static const char* operationNames[OP_COUNT] = {
+    "search", "append", "prepend", "add", "insert", "remove", "trim", "first", "last", "next", "prev"
+};
+
+// Reference model of one list: its items in order, and the position of the current item
+// (-1 before the list, count past it)
+typedef struct Model_s Model;
+struct Model_s
+{
+    List* pList;
+    void** items;
+    int count;
+    int capacity;
+    int current;
+};
+
+typedef struct Writer_s Writer;
+struct Writer_s
+{
+    pthread_t thread;
+    int index;
+    uint64_t random;
+    long opCount;
+    uint64_t* latencies;    //ns per operation
+    int* itemValues;        //items this writer hands out, never reused
+    long nextItem;
+    long deferredCount;     //appends refused while readers held back nodes taken out (epoch mode)
+};
+
+typedef struct Reader_s Reader;
+struct Reader_s
+{
+    pthread_t thread;
+    uint64_t random;
+    long visitCount;
+};
+
+static int weights[OP_COUNT];
+static int weightTotal;
+static Model* models;
+static int modelCount;
+static int writerCount;
+static long poolItems;          //items in every list, under poolLock
+static bool epochReaders;
+static atomic_bool stopReaders;
+static pthread_mutex_t poolLock = PTHREAD_MUTEX_INITIALIZER;
+static uint64_t seed = 1;
+static int absentItem;          //searched for but never in a list
+
+//HELPERS:
+static uint64_t nextRandom(uint64_t* pState) //xorshift64*
+{
+    *pState ^= *pState >> 12;
+    *pState ^= *pState << 25;
+    *pState ^= *pState >> 27;
+    return *pState * 0x2545f4914f6cdd1dULL;
+}
+
+static uint64_t nowNs()
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t) now.tv_sec * 1000000000ULL + now.tv_nsec;
+}
+
+static bool itemEquals(void* pItem, void* pArg)
+{
+    return pItem == pArg;
+}
+
+static bool countItem(void* pItem, void* pContext)
+{
+    (*(long*)pContext)++;
+    return true;
+}
+
+static void freeItem(void* pItem)
+{
+    return;
+}
+
+static int compareLatencies(const void* pLeft, const void* pRight)
+{
+    uint64_t left = *(const uint64_t*)pLeft;
+    uint64_t right = *(const uint64_t*)pRight;
+    return left < right ? -1 : left > right;
+}
+
+//parses a mix such as "search=70,append=20,remove=10", returns false if it names an unknown operation
+static bool parseMix(const char* pMix)
+{
+    char buffer[256];
+    snprintf(buffer, sizeof(buffer), "%s", pMix);
+    memset(weights, 0, sizeof(weights));
+    weightTotal = 0;
+    for (char* pEntry = strtok(buffer, ","); pEntry != NULL; pEntry = strtok(NULL, ","))
+    {
+        char* pEquals = strchr(pEntry, '=');
+        int op = 0;
+        while (pEquals != NULL && op < OP_COUNT && strncmp(pEntry, operationNames[op], pEquals - pEntry) != 0)
+        {
+            op++;
+        }
+        if (pEquals == NULL || op == OP_COUNT || (int) strlen(operationNames[op]) != pEquals - pEntry)
+        {
+            return false;
+        }
+        weights[op] = atoi(pEquals + 1);
+        weightTotal += weights[op];
+    }
+    return weightTotal > 0;
+}
+
+static Operation pickOperation(uint64_t* pRandom)
+{
+    int pick = (int) (nextRandom(pRandom) % weightTotal);
+    int op = 0;
+    while (pick >= weights[op])
+    {
+        pick -= weights[op];
+        op++;
+    }
+    return op;
+}
+
+//MODEL:
+static void* modelCurrent(Model* pModel)
+{
+    return pModel -> current >= 0 && pModel -> current < pModel -> count ? pModel -> items[pModel -> current] : NULL;
+}
+
+//puts pItem at index and makes it the current item
+static void modelInsertAt(Model* pModel, int index, void* pItem)
+{
+    if (pModel -> count == pModel -> capacity)
+    {
+        pModel -> capacity = pModel -> capacity == 0 ? 64 : pModel -> capacity * 2;
+        pModel -> items = realloc(pModel -> items, pModel -> capacity * sizeof(void*));
+        if (pModel -> items == NULL)
+        {
+            fprintf(stderr, "stress: out of memory\n");
+            exit(1);
+        }
+    }
+    memmove(&pModel -> items[index + 1], &pModel -> items[index], (pModel -> count - index) * sizeof(void*));
+    pModel -> items[index] = pItem;
+    pModel -> count++;
+    pModel -> current = index;
+    poolItems++;
+    return;
+}
+
+static void modelRemoveAt(Model* pModel, int index)
+{
+    memmove(&pModel -> items[index], &pModel -> items[index + 1], (pModel -> count - index - 1) * sizeof(void*));
+    pModel -> count--;
+    poolItems--;
+    return;
+}
+
+//runs one operation on a list and on its model, returns false if they disagree
+static bool runOperation(Writer* pWriter, Model* pModel, Operation op, void* pItem, void* pKey)
+{
+    List* pList = pModel -> pList;
+    void* pResult = NULL;
+    void* pExpected = NULL;
+    int added;
+    bool poolFull = poolItems >= LIST_MAX_NUM_NODES;
+    switch (op)
+    {
+        case OP_SEARCH: //from the current item on, as List_search does
+            pResult = List_search(pList, itemEquals, pKey);
+            if (pModel -> current < pModel -> count)
+            {
+                int i = pModel -> current < 0 ? 0 : pModel -> current;
+                while (i < pModel -> count && pModel -> items[i] != pKey)
+                {
+                    i++;
+                }
+                pModel -> current = i;
+                pExpected = modelCurrent(pModel);
+            }
+            break;
+        case OP_APPEND:
+        case OP_PREPEND:
+        case OP_ADD:
+        case OP_INSERT:
+            added = op == OP_APPEND ? List_append(pList, pItem) : op == OP_PREPEND ? List_prepend(pList, pItem)
+                : op == OP_ADD ? List_add(pList, pItem) : List_insert(pList, pItem);
+            if (added != 0)
+            {
+                if (epochReaders && !poolFull) //readers may still hold back nodes taken out
+                {
+                    pWriter -> deferredCount++;
+                    return List_count(pList) == pModel -> count;
+                }
+                return poolFull;
+            }
+            if (poolFull)
+            {
+                return false;
+            }
+            pWriter -> nextItem++;
+            if (op == OP_APPEND || (op == OP_ADD && pModel -> current >= pModel -> count)
+                || (op == OP_INSERT && pModel -> current >= pModel -> count))
+            {
+                modelInsertAt(pModel, pModel -> count, pItem);
+            }
+            else if (op == OP_PREPEND || pModel -> current < 0)
+            {
+                modelInsertAt(pModel, 0, pItem);
+            }
+            else
+            {
+                modelInsertAt(pModel, op == OP_ADD ? pModel -> current + 1 : pModel -> current, pItem);
+            }
+            pResult = pExpected = pItem;
+            break;
+        case OP_REMOVE: //the next item becomes the current one
+            pResult = List_remove(pList);
+            pExpected = modelCurrent(pModel);
+            if (pExpected != NULL)
+            {
+                modelRemoveAt(pModel, pModel -> current);
+            }
+            break;
+        case OP_TRIM: //the new last item becomes the current one
+            pResult = List_trim(pList);
+            if (pModel -> count > 0)
+            {
+                pExpected = pModel -> items[pModel -> count - 1];
+                modelRemoveAt(pModel, pModel -> count - 1);
+                pModel -> current = pModel -> count - 1;
+            }
+            break;
+        case OP_FIRST:
+            pResult = List_first(pList);
+            pModel -> current = 0;
+            pExpected = modelCurrent(pModel);
+            break;
+        case OP_LAST:
+            pResult = List_last(pList);
+            pModel -> current = pModel -> count - 1;
+            pExpected = modelCurrent(pModel);
+            break;
+        case OP_NEXT:
+            pResult = List_next(pList);
+            pModel -> current = pModel -> current < pModel -> count ? pModel -> current + 1 : pModel -> count;
+            pExpected = modelCurrent(pModel);
+            break;
+        case OP_PREV:
+            pResult = List_prev(pList);
+            pModel -> current = pModel -> current >= 0 ? pModel -> current - 1 : -1;
+            pModel -> current = pModel -> current >= pModel -> count ? pModel -> count - 1 : pModel -> current;
+            pExpected = modelCurrent(pModel);
+            break;
+        default:
+            break;
+    }
+    if (pModel -> count == 0) //an empty list has no position left to keep
+    {
+        pModel -> current = -1;
+    }
+    return pResult == pExpected && List_count(pList) == pModel -> count && List_curr(pList) == modelCurrent(pModel);
+}
+
+//THREADS:
+static void* writerMain(void* pArg)
+{
+    Writer* pWriter = pArg;
+    for (long i = 0; i < pWriter -> opCount; i++)
+    {
+        //the writer's lists are those whose index is the writer's modulo the number of writers
+        int listCount = (modelCount - pWriter -> index + writerCount - 1) / writerCount;
+        Model* pModel = &models[pWriter -> index + writerCount * (int) (nextRandom(&pWriter -> random) % listCount)];
+        Operation op = pickOperation(&pWriter -> random);
+        uint64_t pick = nextRandom(&pWriter -> random);
+        void* pItem = &pWriter -> itemValues[pWriter -> nextItem];
+
+        uint64_t start = nowNs();
+        pthread_mutex_lock(&poolLock);
+        void* pKey = pModel -> count == 0 || pick % 8 == 0 ? &absentItem : pModel -> items[pick % pModel -> count];
+        bool matched = runOperation(pWriter, pModel, op, pItem, pKey);
+        pWriter -> latencies[i] = nowNs() - start;
+        pthread_mutex_unlock(&poolLock);
+
+        if (!matched)
+        {
+            fprintf(stderr, "stress: seed %llu, writer %d, operation %ld (%s on list %d): list and model disagree\n",
+                    (unsigned long long) seed, pWriter -> index, i, operationNames[op], pModel -> pList -> headIndex);
+            exit(1);
+        }
+    }
+    return NULL;
+}
+
+static void* readerMain(void* pArg)
+{
+    Reader* pReader = pArg;
+    while (!atomic_load_explicit(&stopReaders, memory_order_relaxed))
+    {
+        List* pList = models[nextRandom(&pReader -> random) % modelCount].pList;
+        if (List_reader_enter() != 0)
+        {
+            fprintf(stderr, "stress: out of reader slots\n");
+            exit(1);
+        }
+        List_foreach(pList, countItem, &pReader -> visitCount);
+        List_reader_exit();
+    }
+    return NULL;
+}
+
+//runs one configuration and prints its line of the report (the run stops if a list disagrees with its model)
+static void runConfiguration(int listCount, int length, long opsPerWriter, int readerCount)
+{
+    if ((long) listCount * length > LIST_MAX_NUM_NODES || listCount > LIST_MAX_NUM_HEADS || listCount < writerCount)
+    {
+        fprintf(stderr, "stress: %d lists of %d items do not fit the pool (%d nodes, %d lists) or %d writers\n",
+                listCount, length, LIST_MAX_NUM_NODES, LIST_MAX_NUM_HEADS, writerCount);
+        return;
+    }
+
+    modelCount = listCount;
+    models = calloc(listCount, sizeof(Model));
+    Writer* writers = calloc(writerCount, sizeof(Writer));
+    Reader* readers = calloc(readerCount > 0 ? readerCount : 1, sizeof(Reader));
+    long itemsPerWriter = opsPerWriter + (long) length * listCount;
+    for (int w = 0; w < writerCount; w++)
+    {
+        writers[w].index = w;
+        writers[w].random = seed * 0x9e3779b97f4a7c15ULL + w + 1;
+        writers[w].opCount = opsPerWriter;
+        writers[w].latencies = malloc(opsPerWriter * sizeof(uint64_t));
+        writers[w].itemValues = malloc(itemsPerWriter * sizeof(int));
+    }
+
+    poolItems = 0;
+    for (int i = 0; i < listCount; i++) //each list starts with length items of its writer
+    {
+        Writer* pWriter = &writers[i % writerCount];
+        models[i].pList = List_create();
+        models[i].current = -1;
+        for (int j = 0; j < length; j++)
+        {
+            void* pItem = &pWriter -> itemValues[pWriter -> nextItem++];
+            List_append(models[i].pList, pItem);
+            modelInsertAt(&models[i], j, pItem);
+        }
+    }
+
+    epochReaders = readerCount > 0;
+    if (epochReaders)
+    {
+        List_epoch_enable();
+    }
+    atomic_store(&stopReaders, false);
+    for (int r = 0; r < readerCount; r++)
+    {
+        readers[r].random = seed * 0x9e3779b97f4a7c15ULL + writerCount + r + 1;
+        pthread_create(&readers[r].thread, NULL, readerMain, &readers[r]);
+    }
+
+    uint64_t start = nowNs();
+    for (int w = 0; w < writerCount; w++)
+    {
+        pthread_create(&writers[w].thread, NULL, writerMain, &writers[w]);
+    }
+    for (int w = 0; w < writerCount; w++)
+    {
+        pthread_join(writers[w].thread, NULL);
+    }
+    double seconds = (nowNs() - start) / 1e9;
+    atomic_store(&stopReaders, true);
+    long visitCount = 0;
+    for (int r = 0; r < readerCount; r++)
+    {
+        pthread_join(readers[r].thread, NULL);
+        visitCount += readers[r].visitCount;
+    }
+
+    //latency percentiles over every operation of every writer
+    long totalOps = opsPerWriter * writerCount;
+    long deferredCount = 0;
+    uint64_t* latencies = malloc(totalOps * sizeof(uint64_t));
+    for (int w = 0; w < writerCount; w++)
+    {
+        memcpy(&latencies[w * opsPerWriter], writers[w].latencies, opsPerWriter * sizeof(uint64_t));
+        deferredCount += writers[w].deferredCount;
+    }
+    qsort(latencies, totalOps, sizeof(uint64_t), compareLatencies);
+    printf("%6d %8d %8d %4d %4d %10.3f %8llu %8llu %8llu %10.1f %9ld\n", listCount, length, LIST_MAX_NUM_NODES,
+           writerCount, readerCount, totalOps / seconds / 1e6,
+           (unsigned long long) latencies[totalOps / 2], (unsigned long long) latencies[totalOps * 99 / 100],
+           (unsigned long long) latencies[totalOps * 999 / 1000], visitCount / seconds / 1e6, deferredCount);
+
+    if (epochReaders)
+    {
+        List_epoch_disable();
+    }
+    for (int i = 0; i < listCount; i++)
+    {
+        List_free(models[i].pList, freeItem);
+        free(models[i].items);
+    }
+    for (int w = 0; w < writerCount; w++)
+    {
+        free(writers[w].latencies);
+        free(writers[w].itemValues);
+    }
+    free(latencies);
+    free(models);
+    free(writers);
+    free(readers);
+    return;
+}
+
+int main(int argCount, char* args[])
+{
+    int listCounts[MAX_CHOICES] = {16};
+    int lengths[MAX_CHOICES] = {256};
+    int listChoiceCount = 0;
+    int lengthChoiceCount = 0;
+    int readerCount = 0;
+    long opsPerWriter = 100000;
+    const char* pMix = DEFAULT_MIX;
+    writerCount = 4;
+
+    for (int i = 1; i < argCount; i++)
+    {
+        const char* pValue = i + 1 < argCount ? args[i + 1] : NULL;
+        if (pValue == NULL)
+        {
+            fprintf(stderr, "stress: %s needs a value\n", args[i]);
+            return 1;
+        }
+        if (strcmp(args[i], "-s") == 0)
+        {
+            seed = strtoull(pValue, NULL, 10);
+        }
+        else if (strcmp(args[i], "-t") == 0)
+        {
+            writerCount = atoi(pValue);
+        }
+        else if (strcmp(args[i], "-r") == 0)
+        {
+            readerCount = atoi(pValue);
+        }
+        else if (strcmp(args[i], "-l") == 0 && listChoiceCount < MAX_CHOICES)
+        {
+            listCounts[listChoiceCount++] = atoi(pValue);
+        }
+        else if (strcmp(args[i], "-n") == 0 && lengthChoiceCount < MAX_CHOICES)
+        {
+            lengths[lengthChoiceCount++] = atoi(pValue);
+        }
+        else if (strcmp(args[i], "-o") == 0)
+        {
+            opsPerWriter = atol(pValue);
+        }
+        else if (strcmp(args[i], "-m") == 0)
+        {
+            pMix = pValue;
+        }
+        else
+        {
+            fprintf(stderr, "stress: unknown option %s\n", args[i]);
+            return 1;
+        }
+        i++;
+    }
+    if (!parseMix(pMix))
+    {
+        fprintf(stderr, "stress: bad operation mix %s\n", pMix);
+        return 1;
+    }
+    if (writerCount < 1 || readerCount < 0 || readerCount > LIST_MAX_READERS || opsPerWriter < 1 || seed == 0)
+    {
+        fprintf(stderr, "stress: need at least one writer and operation, at most %d readers, and a nonzero seed\n",
+                LIST_MAX_READERS);
+        return 1;
+    }
+    listChoiceCount = listChoiceCount == 0 ? 1 : listChoiceCount;
+    lengthChoiceCount = lengthChoiceCount == 0 ? 1 : lengthChoiceCount;
+
+    printf("%6s %8s %8s %4s %4s %10s %8s %8s %8s %10s %9s\n", "lists", "length", "pool", "thr", "rdr",
+           "Mops/s", "p50 ns", "p99 ns", "p999 ns", "Mvisits/s", "deferred");
+    for (int l = 0; l < listChoiceCount; l++)
+    {
+        for (int n = 0; n < lengthChoiceCount; n++)
+        {
+            runConfiguration(listCounts[l], lengths[n], opsPerWriter, readerCount);
+        }
+    }
+    return 0;
+}